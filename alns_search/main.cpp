@@ -0,0 +1,26 @@
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+#include "driver.h"
+#include "solvers/alns_search.h"
+
+using namespace alns_search;
+
+int main()
+{
+    RunSettings settings;
+    settings.vehicleCapacity = 20;
+    settings.maxNumberOfPlacesPerRoute = 3;
+    settings.timeLimitSeconds = 0; // No time limit
+    settings.reportProgress = false;
+
+    uint64_t seed = 42;
+    int iterations = 20000;
+
+    int failures = solveInstances(benchmarkInstances, settings, [&](const Problem& problem) -> std::unique_ptr<Solver> {
+        return std::make_unique<CapacitatedVehicleRoutingProblem>(problem, seed, iterations);
+    });
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,37 +1,33 @@
-import matplotlib.pyplot as plt
-import numpy as np
+import json
+import sys
 
-# Data for the chart
-num_cities = [4, 5, 6, 7, 8, 9, 10]
+import matplotlib.pyplot as plt
 
-# Global Search results
-global_costs = [302, 261, 319, 365, 454, 553, 422]
-global_times = [0, 0, 3, 20, 348, 3960, 37638]
+# Results written by benchmark.py; another results file can be given as the first argument
+results_file = sys.argv[1] if len(sys.argv) > 1 else 'benchmark_results.json'
+with open(results_file) as file:
+    summary = json.load(file)['summary']
 
-# Parallel Global Search results
-parallel_global_costs = [302, 261, 319, 365, 454, 553, 422]
-parallel_global_times = [16, 8, 2, 11, 151, 1546, 18103]
 
-# Local Search results
-local_costs = [326, 281, 369, 430, 540, 571, 526]
-local_times = [444, 525, 644, 741, 899, 1033, 1288]
+def number_of_cities(instance):
+    with open(instance) as file:
+        return int(file.readline())
 
-# Parallel Local Search results
-parallel_local_costs = [326, 281, 369, 430, 574, 571, 526]
-parallel_local_times = [56, 40, 49, 60, 68, 77, 100]
 
-# Parallel Local Search with MPI results
-parallel_mpi_costs = [326, 281, 369, 430, 556, 571, 526]
-parallel_mpi_times = [580, 160, 149, 156, 216, 156, 90]
+# Best cost and median solve time of every solver, in order of instance size
+solvers = {}
+for entry in summary:
+    label = '%s (%d threads, %d ranks)' % (entry['solver'], entry['threads'], entry['ranks'])
+    solvers.setdefault(label, []).append(
+        (number_of_cities(entry['instance']), entry['best_cost'], entry['median_solve_ms']))
+for points in solvers.values():
+    points.sort()
 
 # Plotting the costs
 plt.figure(figsize=(21, 7))
 plt.subplot(1, 3, 1)
-plt.plot(num_cities, global_costs, label='Global Search')
-plt.plot(num_cities, parallel_global_costs, label='Parallel Global Search')
-plt.plot(num_cities, local_costs, label='Local Search')
-plt.plot(num_cities, parallel_local_costs, label='Parallel Local Search')
-plt.plot(num_cities, parallel_mpi_costs, label='Parallel Local Search with MPI')
+for label, points in solvers.items():
+    plt.plot([p[0] for p in points], [p[1] for p in points], label=label)
 plt.xlabel('Number of Cities')
 plt.ylabel('Best Route Cost')
 plt.title('CVRP Algorithm Best Route Costs')
@@ -40,26 +36,20 @@ plt.grid(True)
 
 # Plotting the times
 plt.subplot(1, 3, 2)
-plt.plot(num_cities, global_times, label='Global Search')
-plt.plot(num_cities, parallel_global_times, label='Parallel Global Search')
-plt.plot(num_cities, local_times, label='Local Search')
-plt.plot(num_cities, parallel_local_times, label='Parallel Local Search')
-plt.plot(num_cities, parallel_mpi_times, label='Parallel Local Search with MPI')
+for label, points in solvers.items():
+    plt.plot([p[0] for p in points], [p[2] for p in points], label=label)
 plt.xlabel('Number of Cities')
-plt.ylabel('Time Taken (ms)')
+plt.ylabel('Median Solve Time (ms)')
 plt.title('CVRP Algorithm Times')
 plt.legend()
 plt.grid(True)
 
 # Plotting the times on a logarithmic scale
 plt.subplot(1, 3, 3)
-plt.plot(num_cities, global_times, label='Global Search')
-plt.plot(num_cities, parallel_global_times, label='Parallel Global Search')
-plt.plot(num_cities, local_times, label='Local Search')
-plt.plot(num_cities, parallel_local_times, label='Parallel Local Search')
-plt.plot(num_cities, parallel_mpi_times, label='Parallel Local Search with MPI')
+for label, points in solvers.items():
+    plt.plot([p[0] for p in points], [p[2] for p in points], label=label)
 plt.xlabel('Number of Cities')
-plt.ylabel('Time Taken (ms) (log scale)')
+plt.ylabel('Median Solve Time (ms) (log scale)')
 plt.yscale('log')
 plt.title('CVRP Algorithm Times (Log Scale)')
 plt.legend()
@@ -0,0 +1,240 @@
+"""Runs every solver on a fixed instance set and records the results.
+
+Each solver runs --repetitions times on every instance. Loading and solving are timed
+separately by the programs themselves. Every run is written to <output>.json and
+<output>.csv, with the cost, load and solve time, threads and ranks. With --baseline, the
+best cost and median solve time of each solver and instance are compared against a
+stored run, and the script exits with status 1 if any of them got worse.
+
+    python3 benchmark.py                            # run and write benchmark_results.*
+    python3 benchmark.py --save-baseline base.json  # also store this run as the baseline
+    python3 benchmark.py --baseline base.json       # flag regressions against it
+
+analysing_results.py plots the JSON file.
+"""
+
+import argparse
+import csv
+import datetime
+import json
+import os
+import platform
+import re
+import statistics
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+
+# The instances the per-directory programs have hard-coded, in the same order
+DEFAULT_INSTANCES = [os.path.join("graphs", "graph%d_50.txt" % n) for n in range(4, 11)]
+
+# Shared-memory solvers run through the cvrp binary, which takes the instances as
+# arguments. The MPI solvers are separate programs that run the default instance set.
+SOLVERS = {
+    "global": {"algorithm": "global"},
+    "parallel-global": {"algorithm": "parallel-global"},
+    "dp": {"algorithm": "dp"},
+    "local": {"algorithm": "local"},
+    "parallel-local": {"algorithm": "parallel-local"},
+    "genetic": {"algorithm": "genetic"},
+    "alns": {"algorithm": "alns"},
+    "mpi-local": {"directory": "parallel_local_search"},
+    "mpi-global": {"directory": "global_intrinsically_parallel_search"},
+}
+
+CVRP_DIRECTORY = "cvrp"
+SEPARATOR = "-" * 56
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--solvers", nargs="+", choices=list(SOLVERS), default=list(SOLVERS),
+                        help="solvers to run (default: all)")
+    parser.add_argument("--instances", nargs="+", default=DEFAULT_INSTANCES,
+                        help="instance files; the MPI solvers only run the default set")
+    parser.add_argument("--repetitions", type=int, default=5, help="runs of every solver (default 5)")
+    parser.add_argument("--threads", type=int, default=os.cpu_count(),
+                        help="OpenMP threads per process (default: one per core)")
+    parser.add_argument("--ranks", type=int, default=2, help="MPI processes of the MPI solvers (default 2)")
+    parser.add_argument("--output", default="benchmark_results",
+                        help="path of the results, without extension (default benchmark_results)")
+    parser.add_argument("--baseline", help="results file to compare against")
+    parser.add_argument("--save-baseline", help="also write the results to this file")
+    parser.add_argument("--time-tolerance", type=float, default=0.2,
+                        help="allowed relative slowdown of the median solve time (default 0.2)")
+    parser.add_argument("--time-slack", type=float, default=5.0,
+                        help="slowdowns below this many milliseconds are ignored (default 5)")
+    parser.add_argument("--no-build", action="store_true", help="use the binaries as they are")
+    return parser.parse_args()
+
+
+def build(directories):
+    for directory in directories:
+        result = subprocess.run(["make", "-s", "-C", os.path.join(ROOT, directory)],
+                                stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+        if result.returncode != 0:
+            sys.exit("Building %s failed:\n%s" % (directory, result.stderr))
+
+
+def parse_output(output):
+    """Returns one dict per result block printed by a solver."""
+    results = []
+    for block in output.split(SEPARATOR):
+        instance = re.search(r"Running solution for (\S+)", block)
+        cost = re.search(r"Best route cost: (-?\d+)", block)
+        solve_time = re.search(r"Time taken: ([\d.e+-]+) ms", block)
+        load_time = re.search(r"Load time: ([\d.e+-]+) ms", block)
+        if not (instance and cost and solve_time and load_time):
+            continue
+        results.append({
+            "instance": os.path.normpath(instance.group(1)),
+            "cost": int(cost.group(1)),
+            "load_ms": float(load_time.group(1)),
+            "solve_ms": float(solve_time.group(1)),
+            "stopped_by_budget": "Stopped by the budget" in block,
+        })
+    return results
+
+
+def run_solver(name, arguments):
+    """Runs one repetition of a solver and returns its result blocks."""
+    solver = SOLVERS[name]
+    environment = dict(os.environ, OMP_NUM_THREADS=str(arguments.threads))
+    if "algorithm" in solver:
+        command = [os.path.join(ROOT, CVRP_DIRECTORY, "cvrp"), "--algorithm", solver["algorithm"],
+                   "--threads", str(arguments.threads)]
+        command += [os.path.abspath(instance) for instance in arguments.instances]
+        directory = ROOT
+        ranks = 1
+    else:
+        # Run from the program's directory, where its ../graphs paths resolve
+        directory = os.path.join(ROOT, solver["directory"])
+        command = ["mpirun", "--allow-run-as-root", "--oversubscribe", "-np", str(arguments.ranks),
+                   "-x", "OMP_NUM_THREADS", "./CVRP_Solver"]
+        ranks = arguments.ranks
+
+    result = subprocess.run(command, cwd=directory, env=environment, stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE, text=True)
+    if result.returncode != 0:
+        sys.exit("%s failed:\n%s" % (name, result.stderr))
+
+    runs = parse_output(result.stdout)
+    for run in runs:
+        # Paths relative to the repository, so runs from any directory compare equal
+        path = run["instance"]
+        if not os.path.isabs(path):
+            path = os.path.join(directory, path)
+        run["instance"] = os.path.relpath(path, ROOT)
+        run.update({"solver": name, "threads": arguments.threads, "ranks": ranks})
+    return runs
+
+
+def summarise(runs):
+    """Best cost and median times of every solver, instance, threads and ranks."""
+    groups = {}
+    for run in runs:
+        key = (run["solver"], run["instance"], run["threads"], run["ranks"])
+        groups.setdefault(key, []).append(run)
+
+    summary = []
+    for (solver, instance, threads, ranks), group in groups.items():
+        summary.append({
+            "solver": solver,
+            "instance": instance,
+            "threads": threads,
+            "ranks": ranks,
+            "repetitions": len(group),
+            "best_cost": min(run["cost"] for run in group),
+            "worst_cost": max(run["cost"] for run in group),
+            "median_load_ms": statistics.median(run["load_ms"] for run in group),
+            "median_solve_ms": statistics.median(run["solve_ms"] for run in group),
+            "min_solve_ms": min(run["solve_ms"] for run in group),
+        })
+    return summary
+
+
+def find_regressions(summary, baseline, arguments):
+    reference = {(entry["solver"], entry["instance"], entry["threads"], entry["ranks"]): entry
+                 for entry in baseline["summary"]}
+    regressions = []
+    for entry in summary:
+        key = (entry["solver"], entry["instance"], entry["threads"], entry["ranks"])
+        if key not in reference:
+            continue
+        before = reference[key]
+        label = "%s on %s (%d threads, %d ranks)" % key
+        if entry["best_cost"] > before["best_cost"]:
+            regressions.append("%s: best cost %d, baseline %d" % (label, entry["best_cost"], before["best_cost"]))
+        allowed = before["median_solve_ms"] * (1 + arguments.time_tolerance) + arguments.time_slack
+        if entry["median_solve_ms"] > allowed:
+            regressions.append("%s: median solve time %.1f ms, baseline %.1f ms"
+                               % (label, entry["median_solve_ms"], before["median_solve_ms"]))
+    return regressions
+
+
+def write_results(results, output):
+    with open(output + ".json", "w") as file:
+        json.dump(results, file, indent=2)
+
+    fields = ["solver", "instance", "repetition", "threads", "ranks", "cost", "load_ms", "solve_ms",
+              "stopped_by_budget"]
+    with open(output + ".csv", "w", newline="") as file:
+        writer = csv.DictWriter(file, fieldnames=fields)
+        writer.writeheader()
+        writer.writerows(results["runs"])
+
+
+def main():
+    arguments = parse_arguments()
+
+    if not arguments.no_build:
+        directories = {SOLVERS[name].get("directory", CVRP_DIRECTORY) for name in arguments.solvers}
+        build(sorted(directories))
+
+    default_set = [os.path.normpath(path) for path in arguments.instances] == DEFAULT_INSTANCES
+    runs = []
+    for name in arguments.solvers:
+        if "directory" in SOLVERS[name] and not default_set:
+            print("Skipping %s: it only runs the default instances" % name)
+            continue
+        for repetition in range(arguments.repetitions):
+            for run in run_solver(name, arguments):
+                run["repetition"] = repetition
+                runs.append(run)
+        print("%s: %d repetitions done" % (name, arguments.repetitions))
+
+    summary = summarise(runs)
+    results = {
+        "date": datetime.datetime.now().isoformat(timespec="seconds"),
+        "machine": {"host": platform.node(), "processor": platform.processor(), "cores": os.cpu_count()},
+        "repetitions": arguments.repetitions,
+        "runs": runs,
+        "summary": summary,
+    }
+    write_results(results, arguments.output)
+    if arguments.save_baseline:
+        with open(arguments.save_baseline, "w") as file:
+            json.dump(results, file, indent=2)
+
+    print()
+    print("%-16s %-26s %8s %12s %12s" % ("solver", "instance", "cost", "load (ms)", "solve (ms)"))
+    for entry in summary:
+        print("%-16s %-26s %8d %12.3f %12.3f" % (entry["solver"], entry["instance"], entry["best_cost"],
+                                                entry["median_load_ms"], entry["median_solve_ms"]))
+
+    if arguments.baseline:
+        with open(arguments.baseline) as file:
+            baseline = json.load(file)
+        regressions = find_regressions(summary, baseline, arguments)
+        print()
+        if regressions:
+            print("Regressions against %s:" % arguments.baseline)
+            for regression in regressions:
+                print("  " + regression)
+            sys.exit(1)
+        print("No regressions against %s" % arguments.baseline)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counts every heap allocation made by the program, so a search can report how many it
+// needed beyond its preallocated state. This replaces the global operator new, so a
+// program includes it from one translation unit only. The operators are kept out of line:
+// once inlined, GCC sees free() on memory from operator new and warns about the mismatch.
+inline std::atomic<long long> heapAllocations{0};
+
+__attribute__((noinline)) void* operator new(std::size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
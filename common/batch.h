@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <omp.h>
+
+#include "driver.h"
+
+// Adds the instances of a batch source to `fileNames`: every .txt file of a directory in
+// name order, or every line of a manifest file. Blank manifest lines and lines starting
+// with '#' are skipped, and relative paths are taken from the manifest's directory.
+// Returns false, with the reason in `error`, when the source cannot be read.
+inline bool listBatchInstances(const std::string& source, std::vector<std::string>& fileNames, std::string& error)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code code;
+    if (fs::is_directory(source, code))
+    {
+        std::vector<std::string> directoryFiles;
+        for (const fs::directory_entry& entry : fs::directory_iterator(source, code))
+            if (entry.is_regular_file(code) && entry.path().extension() == ".txt")
+                directoryFiles.push_back(entry.path().string());
+        if (code)
+        {
+            error = source + ": " + code.message();
+            return false;
+        }
+        std::sort(directoryFiles.begin(), directoryFiles.end());
+        fileNames.insert(fileNames.end(), directoryFiles.begin(), directoryFiles.end());
+        return true;
+    }
+
+    std::ifstream manifest(source);
+    if (!manifest)
+    {
+        error = source + ": cannot open the manifest";
+        return false;
+    }
+
+    fs::path manifestDirectory = fs::path(source).parent_path();
+    std::string line;
+    while (std::getline(manifest, line))
+    {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+        size_t last = line.find_last_not_of(" \t\r");
+        fs::path fileName = line.substr(first, last - first + 1);
+        fileNames.push_back(fileName.is_absolute() ? fileName.string() : (manifestDirectory / fileName).string());
+    }
+    return true;
+}
+
+// Solves many instances at once, for dispatch waves of thousands of small instances that
+// take a few milliseconds each. Every OpenMP thread takes the next instance as soon as it
+// is free, then loads and solves it alone. Each result block is printed whole as soon as
+// it is ready, so results come out in completion order rather than in file order.
+//
+// An instance with more than `largeInstanceCustomers` customers would hold its thread long
+// after the others are done. Such instances are kept loaded and solved after the pool, one
+// at a time with every thread, so a threaded engine parallelises within the instance.
+// 0 solves every instance in the pool, which suits the sequential engines.
+//
+// The last line gives the throughput in instances per second. Returns the number of
+// instances that could not be loaded or solved.
+inline int solveBatch(const std::vector<std::string>& fileNames, const RunSettings& settings,
+                      const SolverFactory& createSolver, int largeInstanceCustomers)
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    std::mutex outputMutex;
+    int failures = 0;
+
+    struct LargeInstance
+    {
+        std::string fileName;
+        Instance instance;
+        double loadDuration;
+    };
+    std::vector<LargeInstance> largeInstances;
+
+    // Returns false when the engine cannot take the instance
+    auto solve = [&](const std::string& fileName, const Instance& instance, double loadDuration)
+    {
+        auto startTime = Clock::now();
+        Problem problem = {instance.numberOfPlaces, instance.placesDemand, instance.roads,
+                           settings.vehicleCapacity, settings.maxNumberOfPlacesPerRoute};
+        std::string error;
+        if (!checkLoads(problem, error))
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cerr << "Cannot solve " << fileName << ": " << error << std::endl;
+            return false;
+        }
+
+        std::unique_ptr<Solver> solver = createSolver(problem);
+        if (!solver)
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cerr << "Skipping " << fileName << std::endl;
+            return false;
+        }
+
+        SearchBudget budget(settings.timeLimitSeconds, settings.workLimit);
+        solver->solve(budget);
+        double duration = std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+
+        std::ostringstream result;
+        printResult(result, fileName, solver->solution(), duration, loadDuration,
+                    settings.extraLines + solver->details());
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << result.str() << std::flush;
+        return true;
+    };
+
+    int threads = omp_get_max_threads();
+    auto batchStartTime = Clock::now();
+    instrumentation::beginRun();
+
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:failures)
+    for (size_t i = 0; i < fileNames.size(); ++i)
+    {
+        // Engines started here get this thread alone, sized as such
+        omp_set_num_threads(1);
+
+        auto loadStartTime = Clock::now();
+        Instance instance;
+        std::string error;
+        if (!loadInstance(fileNames[i], instance, error))
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cerr << error << std::endl;
+            ++failures;
+            continue;
+        }
+        double loadDuration = std::chrono::duration<double, std::milli>(Clock::now() - loadStartTime).count();
+
+        if (largeInstanceCustomers > 0 && instance.numberOfPlaces - 1 > largeInstanceCustomers)
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            largeInstances.push_back({fileNames[i], std::move(instance), loadDuration});
+            continue;
+        }
+
+        if (!solve(fileNames[i], instance, loadDuration))
+            ++failures;
+    }
+
+    int largeSolved = 0;
+    for (const LargeInstance& large : largeInstances)
+    {
+        if (solve(large.fileName, large.instance, large.loadDuration))
+            ++largeSolved;
+        else
+            ++failures;
+    }
+
+    instrumentation::endRun("batch");
+    double batchDuration = std::chrono::duration<double, std::milli>(Clock::now() - batchStartTime).count();
+
+    int solved = static_cast<int>(fileNames.size()) - failures;
+    std::cout << "Batch: " << solved << " instances solved, " << failures << " failed, in "
+              << batchDuration << " ms on " << threads << " threads ("
+              << (batchDuration > 0 ? solved * 1000.0 / batchDuration : 0) << " instances/s, "
+              << largeSolved << " large ones solved with every thread)" << std::endl;
+
+    return failures;
+}
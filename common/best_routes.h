@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "problem.h"
+
+// Bounded max-heap of the cheapest complete routes seen so far. Finished tours are
+// folded in as they are found, so memory stays constant instead of growing with the
+// number of feasible solutions.
+class BestRoutes
+{
+    public:
+    explicit BestRoutes(int capacity = 1) : capacity(std::max(capacity, 1)) {}
+
+    // Cost a new route must beat to enter the heap
+    Cost worstKeptCost() const
+    {
+        return isFull() ? routes.front().cost : NO_ROAD;
+    }
+
+    void offer(const Solution& route)
+    {
+        if (route.cost >= worstKeptCost())
+            return;
+
+        if (isFull())
+        {
+            // Reuse the evicted route's storage for the new one
+            std::pop_heap(routes.begin(), routes.end(), costlier);
+            routes.back().places.assign(route.places.begin(), route.places.end());
+            routes.back().cost = route.cost;
+        } else {
+            routes.push_back(route);
+        }
+        std::push_heap(routes.begin(), routes.end(), costlier);
+    }
+
+    void merge(const BestRoutes& other)
+    {
+        for (auto const& route : other.routes)
+            offer(route);
+    }
+
+    // Kept routes from cheapest to most expensive
+    std::vector<Solution> sorted() const
+    {
+        std::vector<Solution> sortedRoutes = routes;
+        std::sort_heap(sortedRoutes.begin(), sortedRoutes.end(), costlier);
+        return sortedRoutes;
+    }
+
+    private:
+    int capacity;
+    std::vector<Solution> routes;
+
+    bool isFull() const
+    {
+        return static_cast<int>(routes.size()) >= capacity;
+    }
+
+    static bool costlier(const Solution& a, const Solution& b)
+    {
+        return a.cost < b.cost;
+    }
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <mutex>
+
+#include "problem.h"
+
+// Work and wall-clock limits for anytime solving. A search charges its work with spend()
+// and stops once either limit is reached, keeping the best route it has found so far.
+// A limit of 0 means no limit. What a unit of work is depends on the solver: an
+// iteration for the heuristics, a node for the exact searches.
+//
+// spend() reads the clock, so hot loops charge their work in batches; exhausted() is a
+// single relaxed load and can be checked on every node. Threads share one budget.
+//
+// With reportProgress set, every new incumbent is written to std::clog together with
+// the time it was found, one "Progress: <ms> ms cost <cost>" line each.
+class SearchBudget
+{
+    public:
+    explicit SearchBudget(double timeLimitSeconds = 0, long long workLimit = 0, bool reportProgress = false)
+        : timeLimit(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeLimitSeconds))),
+          workLimit(workLimit), reportProgress(reportProgress), startTime(Clock::now()) {}
+
+    SearchBudget(const SearchBudget&) = delete;
+    SearchBudget& operator=(const SearchBudget&) = delete;
+
+    // Charges `work` units about to be done. Returns false, from now on for every thread,
+    // once the budget cannot cover them. spend(0) only checks the clock, for long steps
+    // inside one unit of work.
+    bool spend(long long work = 1)
+    {
+        if (exhausted())
+            return false;
+
+        long long workDoneAfter = workDone.fetch_add(work, std::memory_order_relaxed) + work;
+        bool outOfWork = workLimit > 0 && workDoneAfter > workLimit;
+        bool outOfTime = timeLimit.count() > 0 && Clock::now() - startTime >= timeLimit;
+        if (outOfWork || outOfTime)
+        {
+            stopped.store(true, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool exhausted() const
+    {
+        return stopped.load(std::memory_order_relaxed);
+    }
+
+    // Records the cost of a route just found; only a new incumbent is reported
+    void improved(Cost cost)
+    {
+        Cost incumbent = incumbentCost.load(std::memory_order_relaxed);
+        while (cost < incumbent && !incumbentCost.compare_exchange_weak(incumbent, cost, std::memory_order_relaxed));
+        if (cost >= incumbent || !reportProgress)
+            return;
+
+        std::lock_guard<std::mutex> lock(reportMutex);
+        // A cheaper route may have been reported while this thread waited for the lock
+        if (cost > incumbentCost.load(std::memory_order_relaxed))
+            return;
+        std::clog << "Progress: " << elapsedMilliseconds() << " ms cost " << cost << std::endl;
+    }
+
+    // Share of the tightest limit already used, 0 without limits. Lets a schedule such
+    // as an annealing temperature follow the time limit instead of an iteration count.
+    double fractionUsed() const
+    {
+        double fraction = 0;
+        if (workLimit > 0)
+            fraction = static_cast<double>(workDone.load(std::memory_order_relaxed)) / workLimit;
+        if (timeLimit.count() > 0)
+            fraction = std::max(fraction, static_cast<double>((Clock::now() - startTime).count()) / timeLimit.count());
+        return std::min(fraction, 1.0);
+    }
+
+    long long elapsedMilliseconds() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime).count();
+    }
+
+    private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration timeLimit;
+    long long workLimit;
+    bool reportProgress;
+    Clock::time_point startTime;
+    std::atomic<long long> workDone{0};
+    std::atomic<bool> stopped{false};
+    std::atomic<Cost> incumbentCost{INT_MAX};
+    std::mutex reportMutex;
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "problem.h"
+#include "elite_pool.h"
+#include "grasp.h"
+#include "improvement.h"
+#include "instrumentation.h"
+#include "neighbours.h"
+#include "random.h"
+#include "split.h"
+
+// The start of every multi-start iteration of the local searches: a route built from
+// scratch in any ConstructionMode, or a restart from a perturbed elite route. Every method
+// is const and keeps its state on the stack, so threads can share one construction.
+class RouteConstruction
+{
+    public:
+    RouteConstruction(
+        const RoadMatrix& roads,
+        const std::vector<Load>& placesDemand,
+        Load vehicleCapacity,
+        int maxNumberOfPlacesPerRoute,
+        ConstructionMode constructionMode,
+        double graspAlpha,
+        const NeighbourIndex& neighbourIndex
+    ) : roads(roads), placesDemand(placesDemand), vehicleCapacity(vehicleCapacity),
+        maxNumberOfPlacesPerRoute(maxNumberOfPlacesPerRoute), constructionMode(constructionMode),
+        neighbourIndex(neighbourIndex),
+        grasp(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute, graspAlpha, neighbourIndex),
+        split(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute) {}
+
+    // Builds a route from scratch. The cost is NO_ROAD when the construction fails.
+    std::pair<Route, Cost> construct(RandomGenerator& random) const
+    {
+        if (constructionMode == ConstructionMode::GiantTourSplit)
+        {
+            Route giantTour;
+            Route route;
+            Cost cost = grasp.constructGiantTour(random, giantTour) ? split.split(giantTour, route) : NO_ROAD;
+            return std::pair<Route, Cost>(route, cost);
+        }
+
+        if (constructionMode == ConstructionMode::Grasp)
+        {
+            Route route;
+            Cost cost = grasp.construct(random, route);
+            return std::pair<Route, Cost>(route, cost);
+        }
+
+        return constructRandomizedGreedy(random);
+    }
+
+    // Perturbs the giant tour of an elite route with a few random exchanges of customers
+    // and splits it again. Returns false when the pool is empty or the split fails.
+    bool restartFromElite(RandomGenerator& random, const ElitePool& elitePool, int perturbationSwaps, std::pair<Route, Cost>& result) const
+    {
+        Route elite;
+        Cost eliteCost;
+        if (!elitePool.sample(random, elite, eliteCost))
+            return false;
+
+        Route giantTour = GiantTourSplit::giantTourOf(elite);
+        int numberOfCustomers = giantTour.size();
+        if (numberOfCustomers < 2)
+            return false;
+
+        for (int swap = 0; swap < perturbationSwaps; ++swap)
+            std::swap(giantTour[random.nextBelow(numberOfCustomers)], giantTour[random.nextBelow(numberOfCustomers)]);
+
+        result.second = split.split(giantTour, result.first);
+        return result.second != NO_ROAD;
+    }
+
+    // One iteration of a cooperative multi-start. With probability eliteRestartProbability
+    // it restarts from an elite of `elitePool`, otherwise it builds a route from scratch;
+    // the route is then improved and published into `shard` of the pool. Without a pool
+    // every iteration builds from scratch, and without an improvement none is improved.
+    std::pair<Route, Cost> iterate(RandomGenerator& random, ElitePool* elitePool, int shard, double eliteRestartProbability,
+                                   int perturbationSwaps, RouteImprovement* improvement) const
+    {
+        std::pair<Route, Cost> result;
+        bool restarted = elitePool != nullptr && random.nextDouble() < eliteRestartProbability
+            && restartFromElite(random, *elitePool, perturbationSwaps, result);
+        if (!restarted)
+            result = construct(random);
+        if (result.second == NO_ROAD)
+            return result;
+
+        instrumentation::count(instrumentation::RoutesCompleted);
+        if (improvement != nullptr)
+            result.second = improvement->improve(result.first, result.second);
+        if (elitePool != nullptr)
+            elitePool->publish(shard, result.first, result.second);
+        return result;
+    }
+
+    private:
+    const RoadMatrix& roads;
+    const std::vector<Load>& placesDemand;
+    Load vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    ConstructionMode constructionMode;
+    const NeighbourIndex& neighbourIndex;
+    GraspConstruction grasp;
+    GiantTourSplit split;
+
+    std::pair<Route, Cost> constructRandomizedGreedy(RandomGenerator& random) const
+    {
+        PlaceSet placesVisited(roads.size());
+        placesVisited.insert(0);
+        Route route = {0};
+        Cost cost = 0;
+        int numberOfPlacesVisited = 0;
+        Load vehicleLoad = 0;
+
+        int routePlaceIndex = 0;
+        Place currentPlace = route[routePlaceIndex];
+        std::pair<Place, Cost> nextRoad;
+
+        while (placesVisited.size() < roads.size())
+        {
+            nextRoad = findCheaperValidRoad(random, numberOfPlacesVisited, vehicleLoad, placesVisited, currentPlace);
+            // Stranded: no road leaves to an unvisited place or back to the depot
+            if (nextRoad.second == NO_ROAD)
+                return std::pair<Route, Cost>(route, NO_ROAD);
+            placesVisited.insert(nextRoad.first);
+            route.push_back(nextRoad.first);
+            cost += nextRoad.second;
+            vehicleLoad += placesDemand[nextRoad.first];
+            routePlaceIndex++;
+            currentPlace = route[routePlaceIndex];
+        }
+
+        if (roads.cost(route.back(), 0) == NO_ROAD)
+            return std::pair<Route, Cost>(route, NO_ROAD);
+        cost += roads.cost(route.back(), 0);
+        route.push_back(0);
+
+        return std::pair<Route, Cost>(route, cost);
+    }
+
+    std::pair<Place, Cost> findCheaperValidRoad(RandomGenerator& random, int& numberOfPlacesVisited, Load& vehicleLoad, PlaceSet& placesVisited, Place previousPlace) const
+    {
+        std::pair<Place, Cost> cheaperRoad(0, NO_ROAD);
+
+        // The index only holds existing roads, cheapest first
+        for (const Neighbour& road : neighbourIndex.of(previousPlace))
+        {
+            if (!placesVisited.contains(road.place) || road.place == 0)
+            {
+                cheaperRoad = std::pair<Place, Cost>(road.place, road.cost);
+                break;
+            }
+        }
+
+        int numberOfAvailableRoads = neighbourIndex.degree(previousPlace);
+        if (random.nextDouble() > 0.5 && numberOfAvailableRoads > 0)
+        {
+            const Neighbour& randomRoad = neighbourIndex.at(previousPlace, random.nextBelow(numberOfAvailableRoads));
+            Place randomPlace = randomRoad.place;
+
+            if (!placesVisited.contains(randomPlace) || randomPlace == 0)
+                cheaperRoad = std::pair<Place, Cost>(randomPlace, randomRoad.cost);
+        }
+
+        // No road qualifies, which the caller takes as the end of this construction
+        if (cheaperRoad.second == NO_ROAD)
+            return cheaperRoad;
+
+        numberOfPlacesVisited++;
+        vehicleLoad += placesDemand[cheaperRoad.first];
+
+        // Back to the depot, or NO_ROAD when there is no road to it
+        if (vehicleLoad > vehicleCapacity || numberOfPlacesVisited > maxNumberOfPlacesPerRoute)
+            cheaperRoad = std::pair<Place, Cost>(0, roads.cost(previousPlace, 0));
+
+        if (cheaperRoad.first == 0)
+        {
+            numberOfPlacesVisited = 0;
+            vehicleLoad = 0;
+        }
+
+        return cheaperRoad;
+    }
+};
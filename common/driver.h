@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "problem.h"
+#include "budget.h"
+#include "instance.h"
+#include "instrumentation.h"
+#include "solver.h"
+
+// The instances every per-directory program runs, relative to its directory
+inline const std::vector<std::string> benchmarkInstances = {
+    "../graphs/graph4_50.txt",
+    "../graphs/graph5_50.txt",
+    "../graphs/graph6_50.txt",
+    "../graphs/graph7_50.txt",
+    "../graphs/graph8_50.txt",
+    "../graphs/graph9_50.txt",
+    "../graphs/graph10_50.txt",
+};
+
+// How a driver solves its instances
+struct RunSettings
+{
+    Load vehicleCapacity = 20;
+    int maxNumberOfPlacesPerRoute = 3;
+    double timeLimitSeconds = 0; // No time limit
+    long long workLimit = 0; // No work limit
+    bool reportProgress = false;
+    int rank = 0; // Every MPI rank solves, only rank 0 prints
+    std::string extraLines; // Printed after the times of every result, each ending with a newline
+};
+
+// Builds the engine for one problem. Returns nullptr, after saying why, when the engine
+// cannot take it.
+using SolverFactory = std::function<std::unique_ptr<Solver>(const Problem& problem)>;
+
+// The result block every program prints, which benchmark.py parses
+inline void printResult(std::ostream& out, const std::string& fileName, const Solution& solution,
+                        double duration, double loadDuration, const std::string& details)
+{
+    out << "Running solution for " << fileName << "\n";
+    out << "Best route Place sequence: ";
+    for (Place place : solution.places) out << place << " -> ";
+    out << "\n";
+    out << "Best route cost: " << solution.cost << "\n";
+    out << "Time taken: " << duration << " ms\n";
+    out << "Load time: " << loadDuration << " ms\n";
+    out << details;
+    out << "--------------------------------------------------------" << std::endl;
+}
+
+// Loads and solves the instances one after another, printing each result. Returns the
+// number of instances that could not be loaded or solved.
+inline int solveInstances(const std::vector<std::string>& fileNames, const RunSettings& settings,
+                          const SolverFactory& createSolver)
+{
+    int failures = 0;
+    for (const std::string& fileName : fileNames)
+    {
+        auto loadStartTime = std::chrono::high_resolution_clock::now();
+
+        Instance instance;
+        std::string error;
+        if (!loadInstance(fileName, instance, error))
+        {
+            std::cerr << error << std::endl;
+            ++failures;
+            continue;
+        }
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        Problem problem = {instance.numberOfPlaces, instance.placesDemand, instance.roads,
+                           settings.vehicleCapacity, settings.maxNumberOfPlacesPerRoute};
+        if (!checkLoads(problem, error))
+        {
+            std::cerr << "Cannot solve " << fileName << ": " << error << std::endl;
+            ++failures;
+            continue;
+        }
+
+        std::unique_ptr<Solver> solver = createSolver(problem);
+        if (!solver)
+        {
+            std::cerr << "Skipping " << fileName << std::endl;
+            ++failures;
+            continue;
+        }
+
+        SearchBudget budget(settings.timeLimitSeconds, settings.workLimit, settings.reportProgress && settings.rank == 0);
+        instrumentation::beginRun();
+        solver->solve(budget);
+        instrumentation::endRun(fileName, settings.rank);
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        double loadDuration = std::chrono::duration<double, std::milli>(startTime - loadStartTime).count();
+        double duration = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+        if (settings.rank == 0)
+            printResult(std::cout, fileName, solver->solution(), duration, loadDuration,
+                        settings.extraLines + solver->details());
+    }
+
+    return failures;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "problem.h"
+#include "random.h"
+
+// Best routes shared between the threads of a cooperative multi-start. The pool is split
+// into one shard per thread, each with its own lock: a thread publishes into its own shard,
+// so publishing never waits on another thread, and only reads from other shards contend.
+// Each shard keeps its eliteSize cheapest routes with distinct costs, cheapest first.
+class ElitePool
+{
+    public:
+    ElitePool(int numberOfShards, int eliteSize) : eliteSize(eliteSize)
+    {
+        for (int shard = 0; shard < numberOfShards; ++shard)
+            shards.push_back(std::make_unique<Shard>());
+    }
+
+    // Keeps `route` if it beats the worst route of the shard. Returns whether it was kept.
+    bool publish(int shard, const std::vector<Place>& route, Cost cost)
+    {
+        Shard& target = *shards[shard];
+        std::lock_guard<std::mutex> lock(target.mutex);
+
+        std::vector<Elite>& elites = target.elites;
+        if (static_cast<int>(elites.size()) == eliteSize && cost >= elites.back().cost)
+            return false;
+
+        auto position = std::lower_bound(elites.begin(), elites.end(), cost, [](const Elite& elite, Cost value) {
+            return elite.cost < value;
+        });
+        // Same cost is taken as the same solution, so the shard does not fill up with clones
+        if (position != elites.end() && position->cost == cost)
+            return false;
+
+        elites.insert(position, {route, cost});
+        if (static_cast<int>(elites.size()) > eliteSize)
+            elites.pop_back();
+        return true;
+    }
+
+    // Copies a random elite route from a random non-empty shard. Returns false when the
+    // pool is still empty.
+    bool sample(RandomGenerator& random, std::vector<Place>& route, Cost& cost) const
+    {
+        int numberOfShards = shards.size();
+        int firstShard = random.nextBelow(numberOfShards);
+        for (int k = 0; k < numberOfShards; ++k)
+        {
+            Shard& source = *shards[(firstShard + k) % numberOfShards];
+            std::lock_guard<std::mutex> lock(source.mutex);
+            if (source.elites.empty())
+                continue;
+
+            const Elite& elite = source.elites[random.nextBelow(source.elites.size())];
+            route = elite.route;
+            cost = elite.cost;
+            return true;
+        }
+
+        return false;
+    }
+
+    private:
+    struct Elite
+    {
+        std::vector<Place> route;
+        Cost cost;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::vector<Elite> elites;
+    };
+
+    int eliteSize;
+    std::vector<std::unique_ptr<Shard>> shards;
+};
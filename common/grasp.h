@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "neighbours.h"
+#include "problem.h"
+#include "random.h"
+
+// How the local searches build each route
+enum class ConstructionMode
+{
+    RandomizedGreedy,  // 50% cheapest road, 50% any road, with a return to the depot when a limit is hit
+    Grasp,             // Uniform pick from a restricted list of the cheapest feasible roads
+    GiantTourSplit     // GRASP order of all the customers, cut into trips by the optimal split
+};
+
+// Greedy randomized construction (GRASP). The neighbour index keeps the roads of every
+// place sorted by cost, so a step walks that list from the cheapest road and stops as
+// soon as the cost leaves the restricted candidate list: roads no dearer than
+// cheapest + alpha * (dearest - cheapest) among the feasible ones. alpha = 0 is pure
+// greedy and alpha = 1 is uniformly random.
+class GraspConstruction
+{
+    public:
+    GraspConstruction(
+        const RoadMatrix& roads,
+        const std::vector<Load>& placesDemand,
+        Load vehicleCapacity,
+        int maxNumberOfPlacesPerRoute,
+        double alpha,
+        const NeighbourIndex& neighbourIndex
+    ) : roads(roads), placesDemand(placesDemand), vehicleCapacity(vehicleCapacity),
+        maxNumberOfPlacesPerRoute(maxNumberOfPlacesPerRoute), alpha(alpha), neighbourIndex(neighbourIndex) {}
+
+    // Builds a full route from the depot back to the depot into `route` and returns its
+    // cost, or NO_ROAD when some customer cannot be reached within the vehicle limits.
+    Cost construct(RandomGenerator& random, std::vector<Place>& route) const
+    {
+        int numberOfPlaces = roads.size();
+        PlaceSet placesVisited(numberOfPlaces);
+        placesVisited.insert(0);
+
+        route.assign(1, 0);
+        Cost cost = 0;
+        Place currentPlace = 0;
+        Load vehicleLoad = 0;
+        int numberOfPlacesVisited = 0;
+
+        while (placesVisited.size() < numberOfPlaces)
+        {
+            Place nextPlace = pickNextPlace(random, currentPlace, placesVisited, vehicleLoad, numberOfPlacesVisited);
+
+            if (nextPlace == 0)
+            {
+                // Nothing fits anymore: an empty trip means the remaining customers are unreachable
+                if (currentPlace == 0 || !roads.hasRoad(currentPlace, 0))
+                    return NO_ROAD;
+
+                vehicleLoad = 0;
+                numberOfPlacesVisited = 0;
+            } else {
+                placesVisited.insert(nextPlace);
+                vehicleLoad += placesDemand[nextPlace];
+                numberOfPlacesVisited++;
+            }
+
+            cost += roads.cost(currentPlace, nextPlace);
+            route.push_back(nextPlace);
+            currentPlace = nextPlace;
+        }
+
+        if (!roads.hasRoad(currentPlace, 0))
+            return NO_ROAD;
+
+        cost += roads.cost(currentPlace, 0);
+        route.push_back(0);
+        return cost;
+    }
+
+    // Orders every customer into `giantTour` with the same restricted candidate list, but
+    // without vehicle limits: the trips are cut afterwards by GiantTourSplit. When no road
+    // leads on, the walk restarts from the depot. Returns false if a customer is unreachable.
+    bool constructGiantTour(RandomGenerator& random, std::vector<Place>& giantTour) const
+    {
+        int numberOfPlaces = roads.size();
+        PlaceSet placesVisited(numberOfPlaces);
+        placesVisited.insert(0);
+
+        giantTour.clear();
+        Place currentPlace = 0;
+
+        while (placesVisited.size() < numberOfPlaces)
+        {
+            Place nextPlace = pickNextPlace(random, currentPlace, placesVisited, 0, 0);
+            if (nextPlace == 0 && currentPlace != 0)
+                nextPlace = pickNextPlace(random, 0, placesVisited, 0, 0);
+            if (nextPlace == 0)
+                return false;
+
+            placesVisited.insert(nextPlace);
+            giantTour.push_back(nextPlace);
+            currentPlace = nextPlace;
+        }
+
+        return true;
+    }
+
+    private:
+    const RoadMatrix& roads;
+    const std::vector<Load>& placesDemand;
+    Load vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    double alpha;
+    const NeighbourIndex& neighbourIndex;
+
+    // Next customer from the restricted candidate list, or 0 when the vehicle must go back
+    Place pickNextPlace(RandomGenerator& random, Place currentPlace, const PlaceSet& placesVisited, Load vehicleLoad, int numberOfPlacesVisited) const
+    {
+        if (numberOfPlacesVisited >= maxNumberOfPlacesPerRoute)
+            return 0;
+
+        NeighbourIndex::Range neighbours = neighbourIndex.of(currentPlace);
+
+        // The depot is always visited, so only customers are ever candidates
+        auto isFeasible = [&](const Neighbour& road) {
+            return !placesVisited.contains(road.place) && vehicleLoad + placesDemand[road.place] <= vehicleCapacity;
+        };
+
+        // The dearest feasible road bounds the list, so find it from the expensive end
+        const Neighbour* firstFeasible = std::find_if(neighbours.begin(), neighbours.end(), isFeasible);
+        if (firstFeasible == neighbours.end())
+            return 0;
+        const Neighbour* lastFeasible = neighbours.end() - 1;
+        while (!isFeasible(*lastFeasible))
+            --lastFeasible;
+
+        Cost cheapest = firstFeasible->cost;
+        Cost dearest = lastFeasible->cost;
+        Cost threshold = cheapest + static_cast<Cost>(alpha * (dearest - cheapest));
+
+        // Reservoir sampling keeps the pick uniform without storing the list
+        Place chosenPlace = firstFeasible->place;
+        uint32_t numberOfCandidates = 1;
+        for (const Neighbour* road = firstFeasible + 1; road != neighbours.end() && road->cost <= threshold; ++road)
+        {
+            if (isFeasible(*road) && random.nextBelow(++numberOfCandidates) == 0)
+                chosenPlace = road->place;
+        }
+
+        return chosenPlace;
+    }
+};
@@ -0,0 +1,705 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "budget.h"
+#include "problem.h"
+#include "random.h"
+
+// How the local searches improve each constructed route
+enum class ImprovementMode
+{
+    Descent,             // First-improvement moves until none lowers the cost
+    SimulatedAnnealing,  // Random moves, worse ones accepted with a cooling probability
+    TabuSearch           // Best admissible move each step, recently moved customers are tabu
+};
+
+// Improvement phase for the local searches. A route is split into trips and improved with
+// moves from four neighbourhoods:
+//   - 2-opt: reverse a segment of one trip
+//   - relocate: move a customer to another position, in its trip or in any other one
+//   - swap: exchange two customers
+//   - 2-opt*: exchange the tails of two trips
+// Every move respects the vehicle capacity and the number of places per trip. Each trip
+// keeps prefix sums of loads, forward costs and backward costs, so the cost delta of a
+// move, reversed segments included, is evaluated in O(1). The roads may be one-way and
+// missing, so every road a move creates is checked first.
+//
+// improve() runs a descent to a local optimum. anneal() and tabuSearch() keep walking
+// past local optima with the same moves and return the best route they met.
+class RouteImprovement
+{
+    public:
+    RouteImprovement(
+        const RoadMatrix& roads,
+        const std::vector<Load>& placesDemand,
+        Load vehicleCapacity,
+        int maxNumberOfPlacesPerRoute
+    ) : roads(roads), placesDemand(placesDemand), vehicleCapacity(vehicleCapacity),
+        maxNumberOfPlacesPerRoute(maxNumberOfPlacesPerRoute) {}
+
+    // Improves `route` in place and returns its new cost. Routes that are not feasible
+    // (a missing road or a trip over the limits) are left as they are.
+    Cost improve(std::vector<Place>& route, Cost cost)
+    {
+        if (!splitIntoTrips(route))
+            return cost;
+
+        descend();
+        return joinTrips(route);
+    }
+
+    // Simulated annealing over `moves` random moves. The temperature starts where a move
+    // 5% of the route cost dearer is accepted half of the time and cools geometrically
+    // to a thousandth of that. The best route met is finished with a descent. The walk
+    // ends early when `budget` runs out.
+    Cost anneal(std::vector<Place>& route, Cost cost, RandomGenerator& random, int moves, SearchBudget* budget = nullptr)
+    {
+        if (!splitIntoTrips(route))
+            return cost;
+
+        Cost currentCost = cost;
+        Cost bestCost = cost;
+        std::vector<Place> bestRoute = route;
+
+        double temperature = 0.05 * cost / std::log(2.0);
+        double cooling = std::pow(0.001, 1.0 / std::max(moves, 1));
+
+        Move move;
+        for (int step = 0; step < moves; ++step, temperature *= cooling)
+        {
+            if (budget && step % movesPerBudgetCheck == 0 && !budget->spend(0))
+                break;
+            if (!sampleMove(random, move))
+                continue;
+            if (move.delta > 0 && random.nextDouble() >= std::exp(-move.delta / temperature))
+                continue;
+
+            applyMove(move);
+            currentCost += move.delta;
+            if (currentCost < bestCost)
+            {
+                bestCost = currentCost;
+                joinTrips(bestRoute);
+            }
+        }
+
+        route.swap(bestRoute);
+        return improve(route, bestCost);
+    }
+
+    // Tabu search: each step takes the cheapest move whose customers were not moved in the
+    // last few steps, unless it leads to a new best route. The tenure is drawn per move
+    // between minimumTabuTenure and twice that plus a tenth of the customers. The search
+    // ends early when `budget` runs out.
+    Cost tabuSearch(std::vector<Place>& route, Cost cost, RandomGenerator& random, int steps, SearchBudget* budget = nullptr)
+    {
+        if (!splitIntoTrips(route))
+            return cost;
+
+        Cost currentCost = cost;
+        Cost bestCost = cost;
+        std::vector<Place> bestRoute = route;
+
+        int numberOfPlaces = roads.size();
+        std::vector<int> tabuUntil(numberOfPlaces, 0);
+        int tenureRange = minimumTabuTenure + numberOfPlaces / 10;
+
+        for (int step = 1; step <= steps; ++step)
+        {
+            if (budget && !budget->spend(0))
+                break;
+
+            Move chosen;
+            chosen.delta = NO_ROAD;
+            forEachMove([&](const Move& move) {
+                Place first = 0, second = 0;
+                movedCustomers(move, first, second);
+                bool isTabu = tabuUntil[first] >= step || tabuUntil[second] >= step;
+                bool aspires = currentCost + move.delta < bestCost;
+                if ((!isTabu || aspires) && move.delta < chosen.delta)
+                    chosen = move;
+                return false;
+            });
+
+            if (chosen.delta == NO_ROAD)
+                break;
+
+            Place first = 0, second = 0;
+            movedCustomers(chosen, first, second);
+            int tenure = minimumTabuTenure + random.nextBelow(tenureRange + 1);
+            tabuUntil[first] = tabuUntil[second] = step + tenure;
+            tabuUntil[0] = 0;
+
+            applyMove(chosen);
+            currentCost += chosen.delta;
+            if (currentCost < bestCost)
+            {
+                bestCost = currentCost;
+                joinTrips(bestRoute);
+            }
+        }
+
+        route.swap(bestRoute);
+        return bestCost;
+    }
+
+    private:
+    enum class MoveKind
+    {
+        TwoOpt,     // Reverse positions positionA..positionB of tripA
+        Relocate,   // Move the customer at positionA of tripA into the gap after positionB of tripB
+        Swap,       // Exchange the customers at positionA of tripA and positionB of tripB
+        TwoOptStar  // Exchange the tails of tripA and tripB after positions positionA and positionB
+    };
+
+    struct Move
+    {
+        MoveKind kind = MoveKind::TwoOpt;
+        int tripA = 0;
+        int positionA = 0;
+        int tripB = 0;
+        int positionB = 0;
+        Cost delta = 0;
+    };
+
+    static constexpr int minimumTabuTenure = 5;
+
+    // Annealing moves are far cheaper than reading the clock
+    static constexpr int movesPerBudgetCheck = 4096;
+
+    // One trip from the depot back to the depot, with prefix sums over its positions
+    struct Trip
+    {
+        std::vector<Place> places;
+        std::vector<Load> loadUpTo;          // Demand of places[0..k]
+        std::vector<Cost> forwardCostUpTo;   // Cost of driving places[0] -> ... -> places[k]
+        std::vector<Cost> backwardCostUpTo;  // Cost of driving places[k] -> ... -> places[0]
+        std::vector<int> missingBackwardUpTo; // Backward roads missing among places[0..k]
+
+        int numberOfCustomers() const
+        {
+            return places.size() - 2;
+        }
+
+        Load load() const
+        {
+            return loadUpTo.back();
+        }
+
+        Cost cost() const
+        {
+            return forwardCostUpTo.back();
+        }
+    };
+
+    const RoadMatrix& roads;
+    const std::vector<Load>& placesDemand;
+    Load vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    std::vector<Trip> trips;
+
+    // The depot to itself is the empty trip, which costs nothing
+    bool hasLink(Place source, Place destination) const
+    {
+        return (source == 0 && destination == 0) || roads.hasRoad(source, destination);
+    }
+
+    Cost linkCost(Place source, Place destination) const
+    {
+        return (source == 0 && destination == 0) ? 0 : roads.cost(source, destination);
+    }
+
+    void refresh(Trip& trip) const
+    {
+        int length = trip.places.size();
+        trip.loadUpTo.assign(length, 0);
+        trip.forwardCostUpTo.assign(length, 0);
+        trip.backwardCostUpTo.assign(length, 0);
+        trip.missingBackwardUpTo.assign(length, 0);
+
+        for (int k = 1; k < length; ++k)
+        {
+            Place previous = trip.places[k - 1];
+            Place current = trip.places[k];
+            bool backwardExists = hasLink(current, previous);
+
+            trip.loadUpTo[k] = trip.loadUpTo[k - 1] + placesDemand[current];
+            trip.forwardCostUpTo[k] = trip.forwardCostUpTo[k - 1] + linkCost(previous, current);
+            trip.backwardCostUpTo[k] = trip.backwardCostUpTo[k - 1] + (backwardExists ? linkCost(current, previous) : 0);
+            trip.missingBackwardUpTo[k] = trip.missingBackwardUpTo[k - 1] + !backwardExists;
+        }
+    }
+
+    // Writes the trips back as one route and returns its cost
+    Cost joinTrips(std::vector<Place>& route) const
+    {
+        route.assign(1, 0);
+        Cost cost = 0;
+        for (const Trip& trip : trips)
+        {
+            if (trip.numberOfCustomers() == 0)
+                continue;
+
+            route.insert(route.end(), trip.places.begin() + 1, trip.places.end());
+            cost += trip.cost();
+        }
+
+        return cost;
+    }
+
+    bool splitIntoTrips(const std::vector<Place>& route)
+    {
+        trips.clear();
+        if (route.size() < 2 || route.front() != 0 || route.back() != 0)
+            return false;
+
+        Trip trip;
+        trip.places.push_back(0);
+        for (size_t k = 1; k < route.size(); ++k)
+        {
+            if (!roads.hasRoad(route[k - 1], route[k]))
+                return false;
+
+            trip.places.push_back(route[k]);
+            if (route[k] != 0)
+                continue;
+
+            refresh(trip);
+            if (trip.load() > vehicleCapacity || trip.numberOfCustomers() > maxNumberOfPlacesPerRoute)
+                return false;
+
+            trips.push_back(trip);
+            trip.places.assign(1, 0);
+        }
+
+        normalize();
+        return true;
+    }
+
+    // Drops emptied trips and keeps exactly one empty trip at the end, so that relocate
+    // and 2-opt* can also open a new trip
+    void normalize()
+    {
+        std::vector<Trip> keptTrips;
+        keptTrips.reserve(trips.size() + 1);
+        for (Trip& trip : trips)
+        {
+            if (trip.numberOfCustomers() > 0)
+                keptTrips.push_back(std::move(trip));
+        }
+
+        Trip emptyTrip;
+        emptyTrip.places = {0, 0};
+        refresh(emptyTrip);
+        keptTrips.push_back(emptyTrip);
+
+        trips.swap(keptTrips);
+    }
+
+    void descend()
+    {
+        Move improving;
+        auto firstImproving = [&improving](const Move& move) {
+            if (move.delta >= 0)
+                return false;
+            improving = move;
+            return true;
+        };
+
+        while (forEachMove(firstImproving))
+            applyMove(improving);
+    }
+
+    // Calls `visit` on every feasible move, 2-opt first, then relocate, swap and 2-opt*,
+    // until it returns true. Returns whether it stopped early.
+    template <typename Visitor>
+    bool forEachMove(Visitor visit)
+    {
+        int numberOfTrips = trips.size();
+        Move move;
+
+        for (int trip = 0; trip < numberOfTrips; ++trip)
+        {
+            int lastCustomer = trips[trip].numberOfCustomers();
+            for (int first = 1; first < lastCustomer; ++first)
+            {
+                for (int last = first + 1; last <= lastCustomer; ++last)
+                {
+                    if (evaluateTwoOpt(trip, first, last, move) && visit(move))
+                        return true;
+                }
+            }
+        }
+
+        for (int from = 0; from < numberOfTrips; ++from)
+        {
+            for (int position = 1; position <= trips[from].numberOfCustomers(); ++position)
+            {
+                Cost removal;
+                if (!removalDelta(trips[from], position, removal))
+                    continue;
+
+                for (int to = 0; to < numberOfTrips; ++to)
+                {
+                    if (!fitsInto(from, position, to))
+                        continue;
+
+                    for (int gap = 0; gap <= trips[to].numberOfCustomers(); ++gap)
+                    {
+                        if (evaluateInsertion(from, position, removal, to, gap, move) && visit(move))
+                            return true;
+                    }
+                }
+            }
+        }
+
+        for (int first = 0; first < numberOfTrips; ++first)
+        {
+            for (int second = first; second < numberOfTrips; ++second)
+            {
+                for (int positionA = 1; positionA <= trips[first].numberOfCustomers(); ++positionA)
+                {
+                    // Within a trip, neighbours share a road and are left to 2-opt
+                    int firstPositionB = (first == second) ? positionA + 2 : 1;
+                    for (int positionB = firstPositionB; positionB <= trips[second].numberOfCustomers(); ++positionB)
+                    {
+                        if (evaluateSwap(first, positionA, second, positionB, move) && visit(move))
+                            return true;
+                    }
+                }
+            }
+        }
+
+        for (int first = 0; first < numberOfTrips; ++first)
+        {
+            for (int second = first + 1; second < numberOfTrips; ++second)
+            {
+                for (int cutA = 0; cutA <= trips[first].numberOfCustomers(); ++cutA)
+                {
+                    for (int cutB = 0; cutB <= trips[second].numberOfCustomers(); ++cutB)
+                    {
+                        if (evaluateTwoOptStar(first, cutA, second, cutB, move) && visit(move))
+                            return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // A random move from a random neighbourhood, false when it is not feasible. The last
+    // trip is always the spare empty one.
+    bool sampleMove(RandomGenerator& random, Move& move)
+    {
+        int numberOfTrips = trips.size();
+        int nonEmptyTrips = numberOfTrips - 1;
+        if (nonEmptyTrips == 0)
+            return false;
+
+        auto randomCustomer = [&](int trip) {
+            return 1 + static_cast<int>(random.nextBelow(trips[trip].numberOfCustomers()));
+        };
+
+        switch (random.nextBelow(4))
+        {
+            case 0:
+            {
+                int trip = random.nextBelow(nonEmptyTrips);
+                int lastCustomer = trips[trip].numberOfCustomers();
+                if (lastCustomer < 2)
+                    return false;
+                int first = 1 + random.nextBelow(lastCustomer - 1);
+                int last = first + 1 + random.nextBelow(lastCustomer - first);
+                return evaluateTwoOpt(trip, first, last, move);
+            }
+            case 1:
+            {
+                int from = random.nextBelow(nonEmptyTrips);
+                int position = randomCustomer(from);
+                int to = random.nextBelow(numberOfTrips);
+                int gap = random.nextBelow(trips[to].numberOfCustomers() + 1);
+                return evaluateRelocate(from, position, to, gap, move);
+            }
+            case 2:
+            {
+                int first = random.nextBelow(nonEmptyTrips);
+                int second = random.nextBelow(nonEmptyTrips);
+                int positionA = randomCustomer(first);
+                int positionB = randomCustomer(second);
+                if (first > second || (first == second && positionA > positionB))
+                {
+                    std::swap(first, second);
+                    std::swap(positionA, positionB);
+                }
+                if (first == second && positionB < positionA + 2)
+                    return false;
+                return evaluateSwap(first, positionA, second, positionB, move);
+            }
+            default:
+            {
+                int first = random.nextBelow(numberOfTrips);
+                int second = random.nextBelow(numberOfTrips);
+                if (first == second)
+                    return false;
+                if (first > second)
+                    std::swap(first, second);
+                int cutA = random.nextBelow(trips[first].numberOfCustomers() + 1);
+                int cutB = random.nextBelow(trips[second].numberOfCustomers() + 1);
+                return evaluateTwoOptStar(first, cutA, second, cutB, move);
+            }
+        }
+    }
+
+    bool evaluateTwoOpt(int trip, int first, int last, Move& move) const
+    {
+        const Trip& route = trips[trip];
+        const std::vector<Place>& places = route.places;
+        Place before = places[first - 1];
+        Place after = places[last + 1];
+
+        if (route.missingBackwardUpTo[last] != route.missingBackwardUpTo[first])
+            return false;
+        if (!hasLink(before, places[last]) || !hasLink(places[first], after))
+            return false;
+
+        move.kind = MoveKind::TwoOpt;
+        move.tripA = trip;
+        move.positionA = first;
+        move.positionB = last;
+        move.delta = linkCost(before, places[last]) + linkCost(places[first], after)
+            + (route.backwardCostUpTo[last] - route.backwardCostUpTo[first])
+            - (route.forwardCostUpTo[last + 1] - route.forwardCostUpTo[first - 1]);
+        return true;
+    }
+
+    // Cost change of taking the customer at `position` out of its trip
+    bool removalDelta(const Trip& trip, int position, Cost& delta) const
+    {
+        Place before = trip.places[position - 1];
+        Place customer = trip.places[position];
+        Place after = trip.places[position + 1];
+
+        if (!hasLink(before, after))
+            return false;
+
+        delta = linkCost(before, after) - linkCost(before, customer) - linkCost(customer, after);
+        return true;
+    }
+
+    // Cost change of putting `customer` between positions `position` and `position + 1`
+    bool insertionDelta(const Trip& trip, int position, Place customer, Cost& delta) const
+    {
+        Place before = trip.places[position];
+        Place after = trip.places[position + 1];
+
+        if (!hasLink(before, customer) || !hasLink(customer, after))
+            return false;
+
+        delta = linkCost(before, customer) + linkCost(customer, after) - linkCost(before, after);
+        return true;
+    }
+
+    // Whether the customer at `position` of trip `from` can join trip `to`
+    bool fitsInto(int from, int position, int to) const
+    {
+        if (to == from)
+            return true;
+
+        const Trip& target = trips[to];
+        Place customer = trips[from].places[position];
+        return target.load() + placesDemand[customer] <= vehicleCapacity
+            && target.numberOfCustomers() + 1 <= maxNumberOfPlacesPerRoute;
+    }
+
+    bool evaluateRelocate(int from, int position, int to, int gap, Move& move) const
+    {
+        Cost removal;
+        if (!fitsInto(from, position, to) || !removalDelta(trips[from], position, removal))
+            return false;
+
+        return evaluateInsertion(from, position, removal, to, gap, move);
+    }
+
+    // Completes a relocate once the removal is known and the target trip has room
+    bool evaluateInsertion(int from, int position, Cost removal, int to, int gap, Move& move) const
+    {
+        // Within the trip, the gaps next to the customer give back the same route
+        if (to == from && (gap == position - 1 || gap == position))
+            return false;
+
+        Cost insertion;
+        if (!insertionDelta(trips[to], gap, trips[from].places[position], insertion))
+            return false;
+
+        move.kind = MoveKind::Relocate;
+        move.tripA = from;
+        move.positionA = position;
+        move.tripB = to;
+        move.positionB = gap;
+        move.delta = removal + insertion;
+        return true;
+    }
+
+    // Cost change of putting `customer` at `position` in place of the one already there
+    bool replacementDelta(const Trip& trip, int position, Place customer, Cost& delta) const
+    {
+        Place before = trip.places[position - 1];
+        Place replaced = trip.places[position];
+        Place after = trip.places[position + 1];
+
+        if (!hasLink(before, customer) || !hasLink(customer, after))
+            return false;
+
+        delta = linkCost(before, customer) + linkCost(customer, after) - linkCost(before, replaced) - linkCost(replaced, after);
+        return true;
+    }
+
+    bool evaluateSwap(int first, int positionA, int second, int positionB, Move& move) const
+    {
+        const Trip& tripA = trips[first];
+        const Trip& tripB = trips[second];
+        Place customerA = tripA.places[positionA];
+        Place customerB = tripB.places[positionB];
+
+        if (first != second)
+        {
+            Load demandChange = placesDemand[customerB] - placesDemand[customerA];
+            if (tripA.load() + demandChange > vehicleCapacity || tripB.load() - demandChange > vehicleCapacity)
+                return false;
+        }
+
+        Cost delta, otherDelta;
+        if (!replacementDelta(tripA, positionA, customerB, delta) || !replacementDelta(tripB, positionB, customerA, otherDelta))
+            return false;
+
+        move.kind = MoveKind::Swap;
+        move.tripA = first;
+        move.positionA = positionA;
+        move.tripB = second;
+        move.positionB = positionB;
+        move.delta = delta + otherDelta;
+        return true;
+    }
+
+    // Cutting after `cutA` and `cutB`, trip A keeps its head and takes the tail of B
+    bool evaluateTwoOptStar(int first, int cutA, int second, int cutB, Move& move) const
+    {
+        const Trip& tripA = trips[first];
+        const Trip& tripB = trips[second];
+        int customersA = tripA.numberOfCustomers();
+        int customersB = tripB.numberOfCustomers();
+
+        bool wholeTripsExchanged = cutA == 0 && cutB == 0;
+        bool nothingExchanged = cutA == customersA && cutB == customersB;
+        if (wholeTripsExchanged || nothingExchanged)
+            return false;
+
+        if (cutA + (customersB - cutB) > maxNumberOfPlacesPerRoute || cutB + (customersA - cutA) > maxNumberOfPlacesPerRoute)
+            return false;
+        if (tripA.loadUpTo[cutA] + (tripB.load() - tripB.loadUpTo[cutB]) > vehicleCapacity)
+            return false;
+        if (tripB.loadUpTo[cutB] + (tripA.load() - tripA.loadUpTo[cutA]) > vehicleCapacity)
+            return false;
+
+        Place endA = tripA.places[cutA];
+        Place startA = tripA.places[cutA + 1];
+        Place endB = tripB.places[cutB];
+        Place startB = tripB.places[cutB + 1];
+
+        if (!hasLink(endA, startB) || !hasLink(endB, startA))
+            return false;
+
+        move.kind = MoveKind::TwoOptStar;
+        move.tripA = first;
+        move.positionA = cutA;
+        move.tripB = second;
+        move.positionB = cutB;
+        move.delta = linkCost(endA, startB) + linkCost(endB, startA) - linkCost(endA, startA) - linkCost(endB, startB);
+        return true;
+    }
+
+    // The customers a move takes out of their place, the depot standing for none
+    void movedCustomers(const Move& move, Place& first, Place& second) const
+    {
+        const std::vector<Place>& placesA = trips[move.tripA].places;
+        const std::vector<Place>& placesB = trips[move.tripB].places;
+
+        switch (move.kind)
+        {
+            case MoveKind::TwoOpt:
+                first = placesA[move.positionA];
+                second = placesA[move.positionB];
+                break;
+            case MoveKind::Relocate:
+                first = placesA[move.positionA];
+                second = 0;
+                break;
+            case MoveKind::Swap:
+                first = placesA[move.positionA];
+                second = placesB[move.positionB];
+                break;
+            case MoveKind::TwoOptStar:
+                first = placesA[move.positionA + 1];
+                second = placesB[move.positionB + 1];
+                break;
+        }
+    }
+
+    void applyMove(const Move& move)
+    {
+        Trip& tripA = trips[move.tripA];
+        Trip& tripB = trips[move.tripB];
+
+        switch (move.kind)
+        {
+            case MoveKind::TwoOpt:
+                std::reverse(tripA.places.begin() + move.positionA, tripA.places.begin() + move.positionB + 1);
+                refresh(tripA);
+                return;
+
+            case MoveKind::Relocate:
+            {
+                Place customer = tripA.places[move.positionA];
+                if (move.tripA == move.tripB)
+                {
+                    std::vector<Place>& places = tripA.places;
+                    places.erase(places.begin() + move.positionA);
+                    places.insert(places.begin() + (move.positionB < move.positionA ? move.positionB + 1 : move.positionB), customer);
+                } else {
+                    tripB.places.insert(tripB.places.begin() + move.positionB + 1, customer);
+                    tripA.places.erase(tripA.places.begin() + move.positionA);
+                    refresh(tripB);
+                }
+                refresh(tripA);
+                normalize();
+                return;
+            }
+
+            case MoveKind::Swap:
+                std::swap(tripA.places[move.positionA], tripB.places[move.positionB]);
+                refresh(tripA);
+                refresh(tripB);
+                return;
+
+            case MoveKind::TwoOptStar:
+            {
+                std::vector<Place> placesA(tripA.places.begin(), tripA.places.begin() + move.positionA + 1);
+                placesA.insert(placesA.end(), tripB.places.begin() + move.positionB + 1, tripB.places.end());
+                std::vector<Place> placesB(tripB.places.begin(), tripB.places.begin() + move.positionB + 1);
+                placesB.insert(placesB.end(), tripA.places.begin() + move.positionA + 1, tripA.places.end());
+
+                tripA.places.swap(placesA);
+                tripB.places.swap(placesB);
+                refresh(tripA);
+                refresh(tripB);
+                normalize();
+                return;
+            }
+        }
+    }
+};
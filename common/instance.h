@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "problem.h"
+
+// A problem instance as stored in graphs/: the number of customers, one "place demand"
+// line per customer, the number of roads, then one "source destination cost" line per road.
+// Place 0 is the depot and has no line of its own.
+struct Instance
+{
+    int numberOfPlaces = 0; // Customers and the depot
+    std::vector<Load> placesDemand;
+    RoadMatrix roads;
+};
+
+// Most customers an instance may have, which is also the most the generator writes
+constexpr int MAX_INSTANCE_CUSTOMERS = 100000;
+
+// Instances with up to this many places keep their roads in a dense matrix of at most
+// 64 MB. Larger ones keep them in a sparse matrix, of 8 bytes per road, unless the dense
+// one would be no larger, so a 100000-customer instance needs memory for its roads only.
+constexpr int MAX_ALWAYS_DENSE_PLACES = 4096;
+
+// Shortest line a road can take in a file: three one-digit numbers and their separators
+constexpr int MIN_ROAD_LINE_LENGTH = 6;
+
+// Read-only mapping of a whole file, unmapped on destruction
+class MappedFile
+{
+    public:
+    explicit MappedFile(const std::string& fileName)
+    {
+        int descriptor = open(fileName.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return;
+
+        struct stat status;
+        if (fstat(descriptor, &status) == 0)
+        {
+            if (status.st_size == 0)
+                empty = true;
+            else
+            {
+                void* address = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                if (address != MAP_FAILED)
+                {
+                    madvise(address, status.st_size, MADV_SEQUENTIAL);
+                    data = static_cast<const char*>(address);
+                    length = status.st_size;
+                }
+            }
+        }
+        close(descriptor);
+    }
+
+    ~MappedFile()
+    {
+        if (data != nullptr)
+            munmap(const_cast<char*>(data), length);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // An empty file is opened but has nothing to map
+    bool isOpen() const
+    {
+        return data != nullptr || empty;
+    }
+
+    const char* begin() const
+    {
+        return data;
+    }
+
+    const char* end() const
+    {
+        return data + length;
+    }
+
+    private:
+    const char* data = nullptr;
+    size_t length = 0;
+    bool empty = false;
+};
+
+// Reads the whitespace-separated integers of a mapped instance. Every read is checked,
+// and the first failure is kept with the line it happened on.
+class InstanceReader
+{
+    public:
+    InstanceReader(const char* begin, const char* end) : begin(begin), position(begin), end(end) {}
+
+    bool read(int& value, const char* what)
+    {
+        skipWhitespace();
+        if (position == end)
+            return fail(std::string("file ends before the ") + what);
+
+        auto [next, error] = std::from_chars(position, end, value);
+        if (error == std::errc::result_out_of_range)
+            return fail(std::string("the ") + what + " is out of range");
+        if (error != std::errc() || (next != end && !isWhitespace(*next)))
+            return fail(std::string("expected an integer for the ") + what);
+
+        position = next;
+        return true;
+    }
+
+    bool readInRange(int& value, int minimum, int maximum, const char* what)
+    {
+        if (!read(value, what))
+            return false;
+        if (value < minimum || value > maximum)
+            return fail(std::string("the ") + what + " " + std::to_string(value) + " is not between " +
+                        std::to_string(minimum) + " and " + std::to_string(maximum));
+        return true;
+    }
+
+    bool fail(const std::string& message)
+    {
+        if (error.empty())
+            error = "line " + std::to_string(std::count(begin, position, '\n') + 1) + ": " + message;
+        return false;
+    }
+
+    bool atEnd()
+    {
+        skipWhitespace();
+        return position == end;
+    }
+
+    std::string error;
+
+    private:
+    static bool isWhitespace(char character)
+    {
+        return character == ' ' || character == '\t' || character == '\r' || character == '\n';
+    }
+
+    void skipWhitespace()
+    {
+        while (position != end && isWhitespace(*position))
+            ++position;
+    }
+
+    const char* begin;
+    const char* position;
+    const char* end;
+};
+
+// Maps the file and parses it in one pass straight into the instance, checking every
+// count, place id, demand and cost. Returns false, with the reason in `error`, when the
+// file cannot be opened or is malformed; `instance` is then left in an unspecified state.
+inline bool loadInstance(const std::string& fileName, Instance& instance, std::string& error)
+{
+    MappedFile file(fileName);
+    if (!file.isOpen())
+    {
+        error = "Error opening file: " + fileName;
+        return false;
+    }
+
+    InstanceReader reader(file.begin(), file.end());
+    auto failed = [&]() {
+        error = "Error reading " + fileName + ", " + reader.error;
+        return false;
+    };
+
+    int numberOfCustomers;
+    if (!reader.readInRange(numberOfCustomers, 1, MAX_INSTANCE_CUSTOMERS, "number of customers"))
+        return failed();
+
+    int numberOfPlaces = numberOfCustomers + 1;
+    instance.numberOfPlaces = numberOfPlaces;
+    instance.placesDemand.assign(numberOfPlaces, 0);
+
+    std::vector<bool> listed(numberOfPlaces, false);
+    for (int i = 0; i < numberOfCustomers; ++i)
+    {
+        int place, demand;
+        if (!reader.readInRange(place, 1, numberOfCustomers, "customer") ||
+            !reader.readInRange(demand, 0, INT_MAX, "demand"))
+            return failed();
+        if (listed[place])
+        {
+            reader.fail("customer " + std::to_string(place) + " is listed twice");
+            return failed();
+        }
+        listed[place] = true;
+        instance.placesDemand[place] = demand;
+    }
+
+    int numberOfRoads;
+    if (!reader.readInRange(numberOfRoads, 0, INT_MAX, "number of roads"))
+        return failed();
+
+    // The announced count is not trusted for sizing: a file holds at most this many roads
+    long long roadsInFile = std::min<long long>(numberOfRoads, (file.end() - file.begin()) / MIN_ROAD_LINE_LENGTH + 1);
+    bool dense = numberOfPlaces <= MAX_ALWAYS_DENSE_PLACES ||
+                 static_cast<long long>(numberOfPlaces) * numberOfPlaces <= 2 * roadsInFile;
+
+    std::vector<Road> roads;
+    if (dense)
+        instance.roads = RoadMatrix(numberOfPlaces);
+    else
+        roads.reserve(roadsInFile);
+
+    for (int roadId = 0; roadId < numberOfRoads; ++roadId)
+    {
+        int source, destination, cost;
+        if (!reader.readInRange(source, 0, numberOfCustomers, "road source") ||
+            !reader.readInRange(destination, 0, numberOfCustomers, "road destination") ||
+            !reader.readInRange(cost, 0, NO_ROAD - 1, "road cost"))
+            return failed();
+        if (dense)
+            instance.roads.setCost(source, destination, cost);
+        else
+            roads.push_back({source, destination, cost});
+    }
+
+    if (!reader.atEnd())
+    {
+        reader.fail("more roads than the " + std::to_string(numberOfRoads) + " announced");
+        return failed();
+    }
+
+    if (!dense)
+        instance.roads = RoadMatrix(numberOfPlaces, std::move(roads));
+
+    return true;
+}
@@ -0,0 +1,380 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef CVRP_INSTRUMENTATION
+#include "allocation_counter.h"
+#endif
+
+#ifdef CVRP_PERF_EVENTS
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Search counters and thread timers for finding where a solver spends its time. Everything
+// here compiles to nothing unless CVRP_INSTRUMENTATION is defined (make INSTRUMENT=1), so
+// the calls can stay on the hot paths. With CVRP_PERF_EVENTS as well (make PERF_EVENTS=1)
+// each OpenMP thread also reads its hardware counters through perf_event_open.
+//
+// A driver brackets each solve with beginRun() and endRun(label). endRun writes one JSON
+// line to std::clog, prefixed with "Instrumentation: ", holding:
+//   - the counters summed over the threads;
+//   - the heap allocations made during the run;
+//   - for each thread, the time spent busy, idle inside parallel regions, and waiting on MPI;
+//   - the hardware counters, or null when they are not compiled in or not permitted.
+namespace instrumentation
+{
+
+#ifdef CVRP_INSTRUMENTATION
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+enum Counter
+{
+    NodesExpanded,
+    NodesPruned,
+    RoutesCompleted,
+    TasksSpawned,
+    NumberOfCounters
+};
+
+enum Timer
+{
+    Busy,           // Inside a BusyScope
+    Region,         // Inside a RegionScope; idle time is Region - Busy
+    MpiWait,        // Inside an MpiWaitScope
+    NumberOfTimers
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Also builds in programs without OpenMP, which only ever have thread 0. Inside a nested
+// region, such as an engine solving one instance of a batch, every thread would be thread 0
+// of its own team, so the thread of the outermost region is the one counted.
+inline int threadNumber()
+{
+#ifdef _OPENMP
+    return omp_get_level() > 1 ? omp_get_ancestor_thread_num(1) : omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+inline int maxThreads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// Padded to a cache line so that threads never share one
+struct alignas(64) ThreadRecord
+{
+    long long counters[NumberOfCounters] = {};
+    Clock::duration timers[NumberOfTimers] = {};
+    int busyDepth = 0;
+};
+
+#ifdef CVRP_PERF_EVENTS
+// Hardware counters of the calling thread, user space only
+class PerfCounters
+{
+    public:
+    static constexpr int numberOfEvents = 4;
+
+    static const char* name(int event)
+    {
+        static const char* names[numberOfEvents] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+        return names[event];
+    }
+
+    // Returns false when the kernel refuses, as it does under a strict perf_event_paranoid
+    bool open()
+    {
+        static const uint64_t configs[numberOfEvents] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                         PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int event = 0; event < numberOfEvents; ++event)
+        {
+            perf_event_attr attributes;
+            std::memset(&attributes, 0, sizeof(attributes));
+            attributes.size = sizeof(attributes);
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = configs[event];
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            descriptors[event] = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+            if (descriptors[event] < 0)
+            {
+                close();
+                return false;
+            }
+            ioctl(descriptors[event], PERF_EVENT_IOC_RESET, 0);
+        }
+        return true;
+    }
+
+    void read(long long values[numberOfEvents])
+    {
+        for (int event = 0; event < numberOfEvents; ++event)
+        {
+            uint64_t value = 0;
+            if (descriptors[event] < 0 || ::read(descriptors[event], &value, sizeof(value)) != sizeof(value))
+                value = 0;
+            values[event] = value;
+        }
+    }
+
+    void close()
+    {
+        for (int& descriptor : descriptors)
+        {
+            if (descriptor >= 0)
+                ::close(descriptor);
+            descriptor = -1;
+        }
+    }
+
+    private:
+    int descriptors[numberOfEvents] = {-1, -1, -1, -1};
+};
+#endif
+
+class Recorder
+{
+    public:
+    void beginRun()
+    {
+        threads.assign(maxThreads(), ThreadRecord());
+#ifdef CVRP_PERF_EVENTS
+        // Opened from every thread of the pool, which later regions reuse
+        perfCounters.assign(threads.size(), PerfCounters());
+        int failures = 0;
+#ifdef _OPENMP
+        #pragma omp parallel reduction(+:failures)
+#endif
+        failures += !perfCounters[threadNumber()].open();
+        perfAvailable = failures == 0;
+#endif
+#ifdef CVRP_INSTRUMENTATION
+        allocationsAtStart = heapAllocations.load(std::memory_order_relaxed);
+#endif
+        startTime = Clock::now();
+    }
+
+    // Writes the report of the run started by beginRun()
+    void endRun(const std::string& label, int rank = 0)
+    {
+        Clock::duration wallTime = Clock::now() - startTime;
+
+        std::ostringstream report;
+        report << "{\"run\": \"" << escape(label) << "\", \"rank\": " << rank
+               << ", \"wall_ms\": " << milliseconds(wallTime);
+
+        static const char* counterNames[NumberOfCounters] = {"nodes_expanded", "nodes_pruned", "routes_completed",
+                                                             "tasks_spawned"};
+        report << ", \"counters\": {";
+        for (int counter = 0; counter < NumberOfCounters; ++counter)
+        {
+            long long total = 0;
+            for (const ThreadRecord& thread : threads)
+                total += thread.counters[counter];
+            report << (counter ? ", " : "") << "\"" << counterNames[counter] << "\": " << total;
+        }
+        report << "}";
+
+#ifdef CVRP_INSTRUMENTATION
+        report << ", \"heap_allocations\": " << heapAllocations.load(std::memory_order_relaxed) - allocationsAtStart;
+#endif
+
+        report << ", \"threads\": [";
+        for (size_t thread = 0; thread < threads.size(); ++thread)
+        {
+            const ThreadRecord& record = threads[thread];
+            Clock::duration idle = std::max(record.timers[Region] - record.timers[Busy], Clock::duration::zero());
+            report << (thread ? ", " : "") << "{\"thread\": " << thread
+                   << ", \"busy_ms\": " << milliseconds(record.timers[Busy])
+                   << ", \"idle_ms\": " << milliseconds(idle)
+                   << ", \"mpi_wait_ms\": " << milliseconds(record.timers[MpiWait]) << "}";
+        }
+        report << "]";
+
+        report << ", \"perf\": ";
+#ifdef CVRP_PERF_EVENTS
+        if (perfAvailable)
+        {
+            long long totals[PerfCounters::numberOfEvents] = {};
+#ifdef _OPENMP
+            #pragma omp parallel reduction(+:totals[:PerfCounters::numberOfEvents])
+#endif
+            {
+                long long values[PerfCounters::numberOfEvents];
+                perfCounters[threadNumber()].read(values);
+                perfCounters[threadNumber()].close();
+                for (int event = 0; event < PerfCounters::numberOfEvents; ++event)
+                    totals[event] += values[event];
+            }
+            report << "{";
+            for (int event = 0; event < PerfCounters::numberOfEvents; ++event)
+                report << (event ? ", " : "") << "\"" << PerfCounters::name(event) << "\": " << totals[event];
+            report << "}";
+        }
+        else
+        {
+            for (PerfCounters& counters : perfCounters)
+                counters.close();
+            report << "null";
+        }
+#else
+        report << "null";
+#endif
+        report << "}";
+
+        // One write, so lines from different ranks do not interleave
+        std::clog << ("Instrumentation: " + report.str() + "\n") << std::flush;
+    }
+
+    ThreadRecord& thread()
+    {
+        // Threads beyond the ones seen by beginRun() share the last record
+        size_t index = std::min<size_t>(threadNumber(), threads.size() - 1);
+        return threads[index];
+    }
+
+    private:
+    std::vector<ThreadRecord> threads = std::vector<ThreadRecord>(1);
+    Clock::time_point startTime = Clock::now();
+    long long allocationsAtStart = 0;
+#ifdef CVRP_PERF_EVENTS
+    std::vector<PerfCounters> perfCounters;
+    bool perfAvailable = false;
+#endif
+
+    static double milliseconds(Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    static std::string escape(const std::string& text)
+    {
+        std::string escaped;
+        for (char character : text)
+        {
+            if (character == '"' || character == '\\')
+                escaped += '\\';
+            escaped += character;
+        }
+        return escaped;
+    }
+};
+
+inline Recorder recorder;
+
+inline void beginRun()
+{
+    if constexpr (enabled)
+        recorder.beginRun();
+}
+
+inline void endRun(const std::string& label, int rank = 0)
+{
+    if constexpr (enabled)
+        recorder.endRun(label, rank);
+}
+
+// Heap allocations made so far by the whole program, 0 unless instrumented
+inline long long heapAllocationCount()
+{
+#ifdef CVRP_INSTRUMENTATION
+    return heapAllocations.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+inline void count(Counter counter, long long amount = 1)
+{
+    if constexpr (enabled)
+        recorder.thread().counters[counter] += amount;
+}
+
+// Adds the time until the end of the scope to one of the calling thread's timers
+template <Timer timer>
+class Scope
+{
+    public:
+    Scope()
+    {
+        if constexpr (enabled)
+            startTime = Clock::now();
+    }
+
+    ~Scope()
+    {
+        if constexpr (enabled)
+            recorder.thread().timers[timer] += Clock::now() - startTime;
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    private:
+    Clock::time_point startTime;
+};
+
+// Work done by a thread. A task may run inside another one on the same thread, at a
+// task scheduling point, so only the outermost scope of a thread is timed.
+class BusyScope
+{
+    public:
+    BusyScope()
+    {
+        if constexpr (enabled)
+        {
+            outermost = recorder.thread().busyDepth++ == 0;
+            if (outermost)
+                startTime = Clock::now();
+        }
+    }
+
+    ~BusyScope()
+    {
+        if constexpr (enabled)
+        {
+            ThreadRecord& thread = recorder.thread();
+            thread.busyDepth--;
+            if (outermost)
+                thread.timers[Busy] += Clock::now() - startTime;
+        }
+    }
+
+    BusyScope(const BusyScope&) = delete;
+    BusyScope& operator=(const BusyScope&) = delete;
+
+    private:
+    bool outermost = false;
+    Clock::time_point startTime;
+};
+
+// Placed at the top of a parallel region: the time each thread spends in it
+using RegionScope = Scope<Region>;
+
+// Around a blocking MPI call
+using MpiWaitScope = Scope<MpiWait>;
+
+} // namespace instrumentation
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "problem.h"
+
+// A road leaving a place, as stored in the neighbour index
+struct Neighbour
+{
+    Place place;
+    Cost cost;
+};
+
+// Roads that actually exist, grouped by source place in one compressed sparse row array
+// and sorted from the cheapest. Expansion loops walk a place's roads directly instead of
+// scanning a matrix row full of missing ones, and meet the promising roads first.
+//
+// With maxNeighbours > 0 the index is granular: each customer keeps only its maxNeighbours
+// cheapest roads, plus its road back to the depot so a trip can always be closed. The
+// depot keeps all of its roads so every customer can still start a trip. The exact
+// solvers need every road and must use the full index.
+class NeighbourIndex
+{
+    public:
+    NeighbourIndex() = default;
+
+    explicit NeighbourIndex(const RoadMatrix& roads, int maxNeighbours = 0)
+    {
+        int numberOfPlaces = roads.size();
+        offsets.assign(numberOfPlaces + 1, 0);
+
+        std::vector<Neighbour> placeNeighbours;
+        for (Place source = 0; source < numberOfPlaces; ++source)
+        {
+            placeNeighbours.clear();
+            roads.forEachRoad(source, [&](Place destination, Cost cost) {
+                if (destination != source)
+                    placeNeighbours.push_back({destination, cost});
+            });
+
+            // Stable, so equal roads keep the order of their places
+            std::stable_sort(placeNeighbours.begin(), placeNeighbours.end(), [](const Neighbour& a, const Neighbour& b) {
+                return a.cost < b.cost;
+            });
+
+            if (source != 0 && maxNeighbours > 0 && static_cast<int>(placeNeighbours.size()) > maxNeighbours)
+            {
+                auto depotRoad = std::find_if(placeNeighbours.begin(), placeNeighbours.end(), [](const Neighbour& road) {
+                    return road.place == 0;
+                });
+                int keptRoads = maxNeighbours;
+                if (depotRoad != placeNeighbours.end() && depotRoad - placeNeighbours.begin() >= keptRoads)
+                    placeNeighbours[keptRoads++] = *depotRoad;
+                placeNeighbours.resize(keptRoads);
+            }
+
+            neighbours.insert(neighbours.end(), placeNeighbours.begin(), placeNeighbours.end());
+            offsets[source + 1] = neighbours.size();
+        }
+    }
+
+    // Contiguous slice of the roads leaving one place, usable in a range-for
+    struct Range
+    {
+        const Neighbour* first;
+        const Neighbour* last;
+
+        const Neighbour* begin() const
+        {
+            return first;
+        }
+
+        const Neighbour* end() const
+        {
+            return last;
+        }
+    };
+
+    Range of(Place source) const
+    {
+        return {neighbours.data() + offsets[source], neighbours.data() + offsets[source + 1]};
+    }
+
+    int degree(Place source) const
+    {
+        return offsets[source + 1] - offsets[source];
+    }
+
+    // Roads are numbered 0..degree-1 from the cheapest
+    const Neighbour& at(Place source, int rank) const
+    {
+        return neighbours[offsets[source] + rank];
+    }
+
+    private:
+    std::vector<int> offsets;
+    std::vector<Neighbour> neighbours;
+};
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using Place = int;
+using Load = int;
+using Cost = int;
+
+// Cost stored for a pair of places without a direct road
+constexpr Cost NO_ROAD = INT_MAX;
+
+// Places in the order a vehicle visits them. It starts at the depot (place 0), returns
+// to it between trips and ends there.
+using Route = std::vector<Place>;
+
+// A route with its cost, NO_ROAD while no route has been found
+struct Solution
+{
+    Route places;
+    Cost cost = NO_ROAD;
+
+    Solution() = default;
+    Solution(Route places, Cost cost) : places(std::move(places)), cost(cost) {}
+};
+
+// A road as read from an instance file
+struct Road
+{
+    Place source;
+    Place destination;
+    Cost cost;
+};
+
+// Road costs between every pair of places, NO_ROAD where there is no road.
+//
+// A dense matrix is row-major: row `source` holds the cost of every road leaving
+// `source`, so scanning the neighbours of a place touches one contiguous block and a cost
+// is one load. It takes (places)² costs however few roads exist, so large sparse instances
+// use a compressed sparse row matrix instead: the roads leaving each place sorted by
+// destination, whose cost is found by binary search.
+class RoadMatrix
+{
+    public:
+    RoadMatrix() = default;
+
+    // Dense matrix without any road
+    explicit RoadMatrix(int numberOfPlaces)
+        : numberOfPlaces(numberOfPlaces), costs(static_cast<size_t>(numberOfPlaces) * numberOfPlaces, NO_ROAD) {}
+
+    // Sparse matrix of `roads`. When several roads join the same two places, the last one
+    // is kept, as setCost() would on a dense matrix.
+    RoadMatrix(int numberOfPlaces, std::vector<Road> roads) : numberOfPlaces(numberOfPlaces), sparse(true)
+    {
+        std::stable_sort(roads.begin(), roads.end(), [](const Road& a, const Road& b) {
+            return a.source != b.source ? a.source < b.source : a.destination < b.destination;
+        });
+
+        offsets.assign(numberOfPlaces + 1, 0);
+        for (size_t i = 0; i < roads.size(); ++i)
+        {
+            if (i + 1 < roads.size() && roads[i + 1].source == roads[i].source && roads[i + 1].destination == roads[i].destination)
+                continue;
+            destinations.push_back(roads[i].destination);
+            costs.push_back(roads[i].cost);
+            ++offsets[roads[i].source + 1];
+        }
+        for (Place source = 0; source < numberOfPlaces; ++source)
+            offsets[source + 1] += offsets[source];
+    }
+
+    int size() const
+    {
+        return numberOfPlaces;
+    }
+
+    bool hasRoad(Place source, Place destination) const
+    {
+        return cost(source, destination) != NO_ROAD;
+    }
+
+    Cost cost(Place source, Place destination) const
+    {
+        if (!sparse)
+            return costs[static_cast<size_t>(source) * numberOfPlaces + destination];
+
+        const Place* first = destinations.data() + offsets[source];
+        const Place* last = destinations.data() + offsets[source + 1];
+        const Place* road = std::lower_bound(first, last, destination);
+        return road != last && *road == destination ? costs[road - destinations.data()] : NO_ROAD;
+    }
+
+    // Only for a dense matrix
+    void setCost(Place source, Place destination, Cost cost)
+    {
+        costs[static_cast<size_t>(source) * numberOfPlaces + destination] = cost;
+    }
+
+    // Calls visit(destination, cost) for every road leaving `source`, by destination
+    template <typename Visit>
+    void forEachRoad(Place source, Visit visit) const
+    {
+        if (sparse)
+        {
+            for (int road = offsets[source]; road < offsets[source + 1]; ++road)
+                visit(destinations[road], costs[road]);
+            return;
+        }
+
+        const Cost* sourceRoads = costs.data() + static_cast<size_t>(source) * numberOfPlaces;
+        for (Place destination = 0; destination < numberOfPlaces; ++destination)
+            if (sourceRoads[destination] != NO_ROAD)
+                visit(destination, sourceRoads[destination]);
+    }
+
+    private:
+    int numberOfPlaces = 0;
+    bool sparse = false;
+    std::vector<Cost> costs; // Every pair when dense, else the cost of each road in `destinations`
+    std::vector<int> offsets; // Sparse only: the roads leaving place p are [offsets[p], offsets[p + 1])
+    std::vector<Place> destinations;
+};
+
+// What every engine solves: the places with their demands and roads, and the limits of a
+// vehicle trip. It only refers to the roads and demands, so all engines share one copy
+// of them, which must outlive the engine.
+struct Problem
+{
+    int numberOfPlaces; // Customers and the depot
+    const std::vector<Load>& placesDemand;
+    const RoadMatrix& roads;
+    Load vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+};
+
+// Largest vehicle capacity. The engines add a customer's demand to a trip's load before
+// comparing it with the capacity, the randomized greedy construction counts it twice, so a
+// load reaches three times the capacity and must still fit in a Load.
+constexpr Load MAX_VEHICLE_CAPACITY = INT_MAX / 4;
+
+// Checks the problem against the limits every engine relies on: a capacity of at most
+// MAX_VEHICLE_CAPACITY, and no customer asking for more than a vehicle carries, which no
+// route could serve anyway. Returns false, with the reason in `error`, otherwise.
+inline bool checkLoads(const Problem& problem, std::string& error)
+{
+    if (problem.vehicleCapacity > MAX_VEHICLE_CAPACITY)
+    {
+        error = "the vehicle capacity " + std::to_string(problem.vehicleCapacity) + " is above " +
+                std::to_string(MAX_VEHICLE_CAPACITY);
+        return false;
+    }
+
+    for (Place place = 1; place < problem.numberOfPlaces; ++place)
+    {
+        if (problem.placesDemand[place] > problem.vehicleCapacity)
+        {
+            error = "customer " + std::to_string(place) + " demands " + std::to_string(problem.placesDemand[place]) +
+                    ", more than the vehicle capacity " + std::to_string(problem.vehicleCapacity);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Visited set for the exact solvers, one bit per place
+using PlaceMask = uint64_t;
+
+constexpr int MAX_PLACES_IN_MASK = 64;
+
+inline PlaceMask placeBit(Place place)
+{
+    return PlaceMask(1) << place;
+}
+
+inline PlaceMask allPlacesMask(int numberOfPlaces)
+{
+    return numberOfPlaces >= MAX_PLACES_IN_MASK ? ~PlaceMask(0) : placeBit(numberOfPlaces) - 1;
+}
+
+// Visited set for instances of any size, one bit per place packed in 64-bit words
+class PlaceSet
+{
+    public:
+    PlaceSet() = default;
+
+    explicit PlaceSet(int numberOfPlaces) : words((numberOfPlaces + 63) / 64, 0) {}
+
+    bool contains(Place place) const
+    {
+        return (words[place >> 6] >> (place & 63)) & 1;
+    }
+
+    void insert(Place place)
+    {
+        uint64_t bit = uint64_t(1) << (place & 63);
+        numberOfPlaces += !(words[place >> 6] & bit);
+        words[place >> 6] |= bit;
+    }
+
+    void erase(Place place)
+    {
+        uint64_t bit = uint64_t(1) << (place & 63);
+        numberOfPlaces -= !!(words[place >> 6] & bit);
+        words[place >> 6] &= ~bit;
+    }
+
+    void clear()
+    {
+        std::fill(words.begin(), words.end(), 0);
+        numberOfPlaces = 0;
+    }
+
+    int size() const
+    {
+        return numberOfPlaces;
+    }
+
+    private:
+    std::vector<uint64_t> words;
+    int numberOfPlaces = 0;
+};
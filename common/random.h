@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+// Small, fast generator (xoshiro256**) for the randomized searches. Its whole state is
+// four words, so every construction can own one on the stack. Seeding it from a base
+// seed and an iteration index makes each construction reproducible no matter which
+// thread or rank runs it.
+class RandomGenerator
+{
+    public:
+    using result_type = uint64_t;
+
+    explicit RandomGenerator(uint64_t seed = 0)
+    {
+        for (uint64_t& word : state)
+            word = splitMix64(seed);
+    }
+
+    static RandomGenerator forIteration(uint64_t seed, uint64_t iteration)
+    {
+        return RandomGenerator(seed ^ (iteration * 0x9E3779B97F4A7C15ULL));
+    }
+
+    static constexpr result_type min()
+    {
+        return 0;
+    }
+
+    static constexpr result_type max()
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()()
+    {
+        uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+        uint64_t shifted = state[1] << 17;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= shifted;
+        state[3] = rotateLeft(state[3], 45);
+
+        return result;
+    }
+
+    // Uniform double in [0, 1)
+    double nextDouble()
+    {
+        return ((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // Uniform integer in [0, bound), bound > 0
+    uint32_t nextBelow(uint32_t bound)
+    {
+        return static_cast<uint32_t>(((*this)() >> 32) * bound >> 32);
+    }
+
+    private:
+    uint64_t state[4];
+
+    static uint64_t rotateLeft(uint64_t value, int shift)
+    {
+        return (value << shift) | (value >> (64 - shift));
+    }
+
+    static uint64_t splitMix64(uint64_t& seed)
+    {
+        uint64_t value = (seed += 0x9E3779B97F4A7C15ULL);
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+};
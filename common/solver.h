@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "problem.h"
+#include "budget.h"
+
+// The interface every engine implements, so a driver can run any of them the same way.
+// An engine is built from a Problem and its own settings, and solve() may be called once.
+class Solver
+{
+    public:
+    virtual ~Solver() = default;
+
+    // Searches until the engine is done or `budget` is exhausted
+    virtual void solve(SearchBudget& budget) = 0;
+
+    // Best solution found by solve()
+    virtual Solution solution() const = 0;
+
+    // Extra lines of the result block, each ending with a newline, such as the nodes
+    // expanded or why the search stopped early
+    virtual std::string details() const
+    {
+        return "";
+    }
+};
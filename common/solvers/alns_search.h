@@ -0,0 +1,522 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+#include "problem.h"
+#include "budget.h"
+#include "random.h"
+#include "neighbours.h"
+#include "grasp.h"
+#include "solver.h"
+#include "split.h"
+#include "improvement.h"
+
+namespace alns_search
+{
+
+// One vehicle trip. The load and cost are cached so an insertion is priced from the two
+// roads around the gap and a capacity check, without walking the trip.
+struct Trip
+{
+    std::vector<Place> customers;
+    Load load = 0;
+    Cost cost = 0;
+};
+
+// A solution split into its trips, the form destroy and repair work on
+struct TripSolution
+{
+    std::vector<Trip> trips;
+    Cost cost = 0;
+};
+
+// Cheapest place found for a customer: trip index (trips.size() opens a new trip), the
+// position inside that trip and the cost increase.
+struct Insertion
+{
+    int trip = -1;
+    int position = 0;
+    Cost cost = NO_ROAD;
+};
+
+enum class DestroyOperator
+{
+    Random,   // Any customers
+    Worst,    // Customers whose removal saves the most
+    Related,  // Customers close to each other by road cost and demand
+    Count
+};
+
+enum class RepairOperator
+{
+    Greedy,   // Each customer, in random order, at its cheapest place
+    Regret,   // The customer that would lose most by waiting goes first
+    Count
+};
+
+// Adaptive large neighbourhood search. Every iteration removes part of the current
+// solution with one destroy operator and reinserts the removed customers with one repair
+// operator. The operators are drawn by roulette on weights that adapt, every segment of
+// iterations, to the scores they earned: a new best, an improvement, or an accepted
+// worse solution. Worse solutions are accepted with the simulated annealing rule.
+class CapacitatedVehicleRoutingProblem : public Solver
+{
+    public:
+    Route bestRoute;
+    Cost lowerCost = INT_MAX;
+
+    CapacitatedVehicleRoutingProblem(
+        const Problem& problem,
+        uint64_t seed,
+        int iterations = 20000,
+        double minRemovalShare = 0.1,
+        double maxRemovalShare = 0.3
+    ) : numberOfPlaces(problem.numberOfPlaces), vehicleCapacity(problem.vehicleCapacity), maxNumberOfPlacesPerRoute(problem.maxNumberOfPlacesPerRoute),
+        placesDemand(problem.placesDemand), roads(problem.roads), seed(seed), iterations(iterations), minRemovalShare(minRemovalShare),
+        maxRemovalShare(maxRemovalShare) {}
+
+    // Runs until `iterations` destroy and repair steps are done or `budget` is exhausted.
+    // A unit of work is one step, and the temperature cools with whichever of the two
+    // limits is used up faster.
+    void solve(SearchBudget& budget) override
+    {
+        RandomGenerator random(seed);
+        TripSolution current;
+        if (!buildInitialSolution(random, current))
+            return;
+
+        TripSolution best = current;
+        budget.improved(best.cost);
+        std::vector<double> destroyWeights(static_cast<int>(DestroyOperator::Count), 1.0);
+        std::vector<double> repairWeights(static_cast<int>(RepairOperator::Count), 1.0);
+        std::vector<double> destroyScores(destroyWeights.size(), 0), repairScores(repairWeights.size(), 0);
+        std::vector<int> destroyUses(destroyWeights.size(), 0), repairUses(repairWeights.size(), 0);
+
+        // At the start, a solution startingWorsening (5%) worse than the first one is accepted
+        // half of the time; the temperature then falls geometrically to a thousandth of that
+        double startingTemperature = startingWorsening * current.cost / std::log(2.0);
+        double temperature = startingTemperature;
+
+        int numberOfCustomers = numberOfPlaces - 1;
+        int minRemoved = std::max(1, static_cast<int>(minRemovalShare * numberOfCustomers));
+        int maxRemoved = std::min(maxRemovedCustomers, static_cast<int>(maxRemovalShare * numberOfCustomers));
+        // Small instances still need to move a few customers at once
+        maxRemoved = std::max({minRemoved, maxRemoved, std::min(numberOfCustomers, 4)});
+
+        for (int iteration = 0; iteration < iterations && budget.spend(); ++iteration)
+        {
+            int destroyIndex = rouletteWheel(random, destroyWeights);
+            int repairIndex = rouletteWheel(random, repairWeights);
+            int numberToRemove = minRemoved + random.nextBelow(maxRemoved - minRemoved + 1);
+
+            TripSolution candidate = current;
+            std::vector<Place> removed;
+            destroy(static_cast<DestroyOperator>(destroyIndex), random, candidate, numberToRemove, removed);
+            bool repaired = repair(static_cast<RepairOperator>(repairIndex), random, candidate, removed);
+
+            double score = 0;
+            if (repaired)
+            {
+                bool accepted = candidate.cost < current.cost
+                    || random.nextDouble() < std::exp(-(candidate.cost - current.cost) / temperature);
+
+                if (candidate.cost < best.cost)
+                    score = newBestScore;
+                else if (candidate.cost < current.cost)
+                    score = improvementScore;
+                else if (accepted && candidate.cost > current.cost)
+                    score = acceptedScore;
+
+                if (accepted)
+                    current = std::move(candidate);
+                if (current.cost < best.cost)
+                {
+                    best = current;
+                    budget.improved(best.cost);
+                }
+            }
+
+            destroyScores[destroyIndex] += score;
+            destroyUses[destroyIndex]++;
+            repairScores[repairIndex] += score;
+            repairUses[repairIndex]++;
+
+            if ((iteration + 1) % segmentLength == 0)
+            {
+                updateWeights(destroyWeights, destroyScores, destroyUses);
+                updateWeights(repairWeights, repairScores, repairUses);
+            }
+            double progress = std::max(static_cast<double>(iteration + 1) / iterations, budget.fractionUsed());
+            temperature = startingTemperature * std::pow(0.001, progress);
+        }
+
+        bestRoute = toRoute(best);
+        lowerCost = best.cost;
+    }
+
+    Solution solution() const override
+    {
+        return Solution(bestRoute, lowerCost);
+    }
+
+    private:
+    int numberOfPlaces;
+    int vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    const std::vector<Load>& placesDemand;
+    const RoadMatrix& roads;
+    uint64_t seed;
+    int iterations;
+    double minRemovalShare;
+    double maxRemovalShare;
+
+    static constexpr int maxRemovedCustomers = 40;
+    static constexpr double startingWorsening = 0.05;
+
+    // Scores and weight update as in Ropke and Pisinger
+    static constexpr double newBestScore = 33;
+    static constexpr double improvementScore = 9;
+    static constexpr double acceptedScore = 13;
+    static constexpr int segmentLength = 100;
+    static constexpr double reactionFactor = 0.1;
+
+    // Higher values make worst and related removal pick the top of their ranking more often
+    static constexpr double removalDeterminism = 3;
+
+    bool buildInitialSolution(RandomGenerator& random, TripSolution& solution) const
+    {
+        NeighbourIndex neighbourIndex(roads);
+        GraspConstruction grasp(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute, 1.0, neighbourIndex);
+        GiantTourSplit split(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute);
+        RouteImprovement improvement(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute);
+
+        Route giantTour;
+        Route route;
+        if (!grasp.constructGiantTour(random, giantTour))
+            return false;
+
+        Cost cost = split.split(giantTour, route);
+        if (cost == NO_ROAD)
+            return false;
+
+        improvement.improve(route, cost);
+        solution = fromRoute(route);
+        return true;
+    }
+
+    TripSolution fromRoute(const Route& route) const
+    {
+        TripSolution solution;
+        Trip trip;
+        for (size_t k = 1; k < route.size(); ++k)
+        {
+            if (route[k] != 0)
+            {
+                trip.customers.push_back(route[k]);
+                continue;
+            }
+
+            if (!trip.customers.empty())
+            {
+                refreshTrip(trip);
+                solution.trips.push_back(trip);
+                solution.cost += trip.cost;
+            }
+            trip.customers.clear();
+        }
+        return solution;
+    }
+
+    static Route toRoute(const TripSolution& solution)
+    {
+        Route route = {0};
+        for (const Trip& trip : solution.trips)
+        {
+            route.insert(route.end(), trip.customers.begin(), trip.customers.end());
+            route.push_back(0);
+        }
+        return route;
+    }
+
+    // Recomputes the cached load and cost, NO_ROAD when a road of the trip is missing
+    void refreshTrip(Trip& trip) const
+    {
+        trip.load = 0;
+        trip.cost = 0;
+        Place previous = 0;
+        for (Place customer : trip.customers)
+        {
+            trip.load += placesDemand[customer];
+            if (trip.cost != NO_ROAD)
+                trip.cost = roads.hasRoad(previous, customer) ? trip.cost + roads.cost(previous, customer) : NO_ROAD;
+            previous = customer;
+        }
+        if (trip.cost != NO_ROAD)
+            trip.cost = roads.hasRoad(previous, 0) ? trip.cost + roads.cost(previous, 0) : NO_ROAD;
+    }
+
+    static int rouletteWheel(RandomGenerator& random, const std::vector<double>& weights)
+    {
+        double total = 0;
+        for (double weight : weights)
+            total += weight;
+
+        double target = random.nextDouble() * total;
+        for (size_t k = 0; k + 1 < weights.size(); ++k)
+        {
+            if (target < weights[k])
+                return k;
+            target -= weights[k];
+        }
+        return weights.size() - 1;
+    }
+
+    static void updateWeights(std::vector<double>& weights, std::vector<double>& scores, std::vector<int>& uses)
+    {
+        for (size_t k = 0; k < weights.size(); ++k)
+        {
+            if (uses[k] > 0)
+                weights[k] = weights[k] * (1 - reactionFactor) + reactionFactor * scores[k] / uses[k];
+            weights[k] = std::max(weights[k], 0.01);
+            scores[k] = 0;
+            uses[k] = 0;
+        }
+    }
+
+    // Index into a ranking of `size` entries, biased towards its front
+    static int biasedRank(RandomGenerator& random, int size)
+    {
+        return static_cast<int>(std::pow(random.nextDouble(), removalDeterminism) * size);
+    }
+
+    void destroy(DestroyOperator destroyOperator, RandomGenerator& random, TripSolution& solution, int numberToRemove, std::vector<Place>& removed) const
+    {
+        std::vector<bool> isRemoved(numberOfPlaces, false);
+        std::vector<Place> customers;
+        for (const Trip& trip : solution.trips)
+            customers.insert(customers.end(), trip.customers.begin(), trip.customers.end());
+        numberToRemove = std::min<int>(numberToRemove, customers.size());
+
+        if (destroyOperator == DestroyOperator::Random)
+        {
+            for (int k = 0; k < numberToRemove; ++k)
+            {
+                int pick = k + random.nextBelow(customers.size() - k);
+                std::swap(customers[k], customers[pick]);
+                isRemoved[customers[k]] = true;
+            }
+        } else if (destroyOperator == DestroyOperator::Worst) {
+            // Saving of every customer, measured once on the intact solution
+            std::vector<Cost> saving(numberOfPlaces, 0);
+            for (const Trip& trip : solution.trips)
+            {
+                for (size_t k = 0; k < trip.customers.size(); ++k)
+                {
+                    Place before = k == 0 ? 0 : trip.customers[k - 1];
+                    Place after = k + 1 == trip.customers.size() ? 0 : trip.customers[k + 1];
+                    Place customer = trip.customers[k];
+                    Cost bypass = roads.hasRoad(before, after) ? roads.cost(before, after) : 0;
+                    saving[customer] = roads.cost(before, customer) + roads.cost(customer, after) - bypass;
+                }
+            }
+
+            std::stable_sort(customers.begin(), customers.end(), [&saving](Place a, Place b) {
+                return saving[a] > saving[b];
+            });
+            for (int k = 0; k < numberToRemove; ++k)
+            {
+                int pick = k + biasedRank(random, customers.size() - k);
+                std::rotate(customers.begin() + k, customers.begin() + pick, customers.begin() + pick + 1);
+                isRemoved[customers[k]] = true;
+            }
+        } else {
+            Place seedCustomer = customers[random.nextBelow(customers.size())];
+            std::vector<Place> removedSoFar = {seedCustomer};
+            isRemoved[seedCustomer] = true;
+
+            std::vector<Place> candidates;
+            while (static_cast<int>(removedSoFar.size()) < numberToRemove)
+            {
+                Place reference = removedSoFar[random.nextBelow(removedSoFar.size())];
+
+                candidates.clear();
+                for (Place customer : customers)
+                {
+                    if (!isRemoved[customer])
+                        candidates.push_back(customer);
+                }
+                std::stable_sort(candidates.begin(), candidates.end(), [&](Place a, Place b) {
+                    return relatedness(reference, a) < relatedness(reference, b);
+                });
+
+                Place chosen = candidates[biasedRank(random, candidates.size())];
+                isRemoved[chosen] = true;
+                removedSoFar.push_back(chosen);
+            }
+        }
+
+        removeCustomers(solution, isRemoved, removed);
+    }
+
+    // Lower is more related: the cheaper road between the two customers, plus their
+    // difference in demand. Customers without a road either way are the least related.
+    double relatedness(Place a, Place b) const
+    {
+        Cost road = std::min(roads.cost(a, b), roads.cost(b, a));
+        double distance = road == NO_ROAD ? 1e9 : road;
+        return distance + std::abs(placesDemand[a] - placesDemand[b]);
+    }
+
+    // Takes the marked customers out. A trip left with a missing road is cut into the
+    // pieces that still have roads, and a piece that cannot reach the depot both ways is
+    // removed as well, so every remaining trip stays feasible.
+    void removeCustomers(TripSolution& solution, std::vector<bool>& isRemoved, std::vector<Place>& removed) const
+    {
+        std::vector<Trip> keptTrips;
+        solution.cost = 0;
+
+        for (const Trip& trip : solution.trips)
+        {
+            Trip piece;
+            for (size_t k = 0; k <= trip.customers.size(); ++k)
+            {
+                bool endOfTrip = k == trip.customers.size();
+                Place customer = endOfTrip ? 0 : trip.customers[k];
+                if (!endOfTrip && isRemoved[customer])
+                {
+                    removed.push_back(customer);
+                    continue;
+                }
+
+                bool continuesPiece = !endOfTrip && (piece.customers.empty() || roads.hasRoad(piece.customers.back(), customer));
+                if (continuesPiece)
+                {
+                    piece.customers.push_back(customer);
+                    continue;
+                }
+
+                if (!piece.customers.empty())
+                {
+                    refreshTrip(piece);
+                    if (piece.cost != NO_ROAD)
+                    {
+                        solution.cost += piece.cost;
+                        keptTrips.push_back(piece);
+                    } else {
+                        removed.insert(removed.end(), piece.customers.begin(), piece.customers.end());
+                    }
+                }
+                piece.customers.clear();
+                if (!endOfTrip)
+                    piece.customers.push_back(customer);
+            }
+        }
+
+        solution.trips.swap(keptTrips);
+    }
+
+    // Cheapest place for `customer` in `trip`, with the trip's cached load and size
+    void bestInsertionInTrip(const Trip& trip, int tripIndex, Place customer, Insertion& best, Insertion& secondBest) const
+    {
+        if (trip.load + placesDemand[customer] > vehicleCapacity || static_cast<int>(trip.customers.size()) >= maxNumberOfPlacesPerRoute)
+            return;
+
+        Insertion tripBest;
+        for (size_t position = 0; position <= trip.customers.size(); ++position)
+        {
+            Place before = position == 0 ? 0 : trip.customers[position - 1];
+            Place after = position == trip.customers.size() ? 0 : trip.customers[position];
+            if (!roads.hasRoad(before, customer) || !roads.hasRoad(customer, after))
+                continue;
+
+            // A new trip has no road to bypass
+            Cost bypass = trip.customers.empty() ? 0 : roads.cost(before, after);
+            Cost cost = roads.cost(before, customer) + roads.cost(customer, after) - bypass;
+            if (cost < tripBest.cost)
+                tripBest = {tripIndex, static_cast<int>(position), cost};
+        }
+
+        // Regret compares the best place in different trips
+        if (tripBest.cost < best.cost)
+        {
+            secondBest = best;
+            best = tripBest;
+        } else if (tripBest.cost < secondBest.cost) {
+            secondBest = tripBest;
+        }
+    }
+
+    void bestInsertion(const TripSolution& solution, Place customer, Insertion& best, Insertion& secondBest) const
+    {
+        best = Insertion();
+        secondBest = Insertion();
+        for (size_t t = 0; t < solution.trips.size(); ++t)
+            bestInsertionInTrip(solution.trips[t], t, customer, best, secondBest);
+
+        Trip newTrip;
+        bestInsertionInTrip(newTrip, solution.trips.size(), customer, best, secondBest);
+    }
+
+    void insert(TripSolution& solution, Place customer, const Insertion& insertion) const
+    {
+        if (insertion.trip == static_cast<int>(solution.trips.size()))
+            solution.trips.push_back(Trip());
+
+        Trip& trip = solution.trips[insertion.trip];
+        trip.customers.insert(trip.customers.begin() + insertion.position, customer);
+        trip.load += placesDemand[customer];
+        trip.cost += insertion.cost;
+        solution.cost += insertion.cost;
+    }
+
+    // Reinserts every removed customer, false when one of them fits nowhere
+    bool repair(RepairOperator repairOperator, RandomGenerator& random, TripSolution& solution, std::vector<Place>& removed) const
+    {
+        Insertion best, secondBest;
+
+        if (repairOperator == RepairOperator::Greedy)
+        {
+            std::shuffle(removed.begin(), removed.end(), random);
+            for (Place customer : removed)
+            {
+                bestInsertion(solution, customer, best, secondBest);
+                if (best.cost == NO_ROAD)
+                    return false;
+                insert(solution, customer, best);
+            }
+            return true;
+        }
+
+        while (!removed.empty())
+        {
+            int chosen = -1;
+            Insertion chosenInsertion;
+            Cost highestRegret = -1;
+
+            for (size_t k = 0; k < removed.size(); ++k)
+            {
+                bestInsertion(solution, removed[k], best, secondBest);
+                if (best.cost == NO_ROAD)
+                    return false;
+
+                // A customer with a single option must go now
+                Cost regret = secondBest.cost == NO_ROAD ? INT_MAX : secondBest.cost - best.cost;
+                if (regret > highestRegret)
+                {
+                    highestRegret = regret;
+                    chosen = k;
+                    chosenInsertion = best;
+                }
+            }
+
+            insert(solution, removed[chosen], chosenInsertion);
+            removed.erase(removed.begin() + chosen);
+        }
+        return true;
+    }
+};
+
+} // namespace alns_search
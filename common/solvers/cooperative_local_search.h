@@ -0,0 +1,120 @@
+#pragma once
+
+#include <climits>
+#include <vector>
+#include <omp.h>
+
+#include "problem.h"
+#include "budget.h"
+#include "elite_pool.h"
+#include "instrumentation.h"
+#include "random.h"
+#include "construction.h"
+#include "improvement.h"
+#include "neighbours.h"
+#include "solver.h"
+
+namespace cooperative_local_search
+{
+
+class CapacitatedVehicleRoutingProblem : public Solver
+{
+    public:
+    Route bestRoute;
+    Cost lowerCost = INT_MAX;
+
+    CapacitatedVehicleRoutingProblem(
+        const Problem& problem,
+        uint64_t seed,
+        ConstructionMode constructionMode = ConstructionMode::RandomizedGreedy,
+        double graspAlpha = 0.3,
+        int iterations = 10000,
+        bool improveRoutes = false,
+        int maxNeighbours = 0,
+        bool cooperative = false,
+        int eliteSize = 8,
+        double eliteRestartProbability = 0.8,
+        int perturbationSwaps = 3
+    ) : numberOfPlaces(problem.numberOfPlaces), vehicleCapacity(problem.vehicleCapacity), maxNumberOfPlacesPerRoute(problem.maxNumberOfPlacesPerRoute), placesDemand(problem.placesDemand), roads(problem.roads), seed(seed), constructionMode(constructionMode), graspAlpha(graspAlpha), iterations(iterations), improveRoutes(improveRoutes), maxNeighbours(maxNeighbours), cooperative(cooperative), eliteSize(eliteSize), eliteRestartProbability(eliteRestartProbability), perturbationSwaps(perturbationSwaps) {}
+
+    // Runs until `iterations` constructions are done or `budget` is exhausted. A unit of
+    // work is one construction, and every thread charges the same budget.
+    void solve(SearchBudget& budget) override
+    {
+        neighbourIndex = NeighbourIndex(roads, maxNeighbours);
+        RouteConstruction construction(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute, constructionMode, graspAlpha, neighbourIndex);
+
+        int bestIteration = INT_MAX;
+        ElitePool elitePool(omp_get_max_threads(), eliteSize);
+
+        #pragma omp parallel
+        {
+            instrumentation::RegionScope region;
+            Route localBestRoute;
+            Cost localLowerCost = INT_MAX;
+            int localBestIteration = INT_MAX;
+            RouteImprovement improvement(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute);
+            int shard = omp_get_thread_num();
+
+            // Handed out one by one, so every thread restarts from elites found by the others.
+            // Cooperative results depend on thread timing; independent ones do not.
+            #pragma omp for schedule(dynamic)
+            for (int i = 0; i < iterations; ++i)
+            {
+                // A worksharing loop cannot break, so the iterations left are skipped
+                if (!budget.spend())
+                    continue;
+
+                instrumentation::BusyScope busy;
+                RandomGenerator random = RandomGenerator::forIteration(seed, i);
+                std::pair<Route, Cost> result = construction.iterate(random, cooperative ? &elitePool : nullptr, shard,
+                    eliteRestartProbability, perturbationSwaps, improveRoutes ? &improvement : nullptr);
+                budget.improved(result.second);
+                if (result.second < localLowerCost)
+                {
+                    localBestRoute = result.first;
+                    localLowerCost = result.second;
+                    localBestIteration = i;
+                }
+            }
+
+            #pragma omp critical
+            {
+                // Ties go to the earliest iteration so the result does not depend on thread timing
+                bool cheaper = localLowerCost < lowerCost;
+                bool tiedButEarlier = localLowerCost == lowerCost && localBestIteration < bestIteration;
+                if (cheaper || tiedButEarlier)
+                {
+                    bestRoute = localBestRoute;
+                    lowerCost = localLowerCost;
+                    bestIteration = localBestIteration;
+                }
+            }
+        }
+    }
+
+    Solution solution() const override
+    {
+        return Solution(bestRoute, lowerCost);
+    }
+
+    private:
+    int numberOfPlaces;
+    int vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    const std::vector<Load>& placesDemand;
+    const RoadMatrix& roads;
+    uint64_t seed;
+    ConstructionMode constructionMode;
+    double graspAlpha;
+    int iterations;
+    bool improveRoutes;
+    int maxNeighbours;
+    bool cooperative;
+    int eliteSize;
+    double eliteRestartProbability;
+    int perturbationSwaps;
+    NeighbourIndex neighbourIndex;
+};
+
+} // namespace cooperative_local_search
@@ -0,0 +1,356 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "problem.h"
+#include "budget.h"
+#include "grasp.h"
+#include "neighbours.h"
+#include "random.h"
+#include "solver.h"
+#include "split.h"
+
+namespace dynamic_programming_search
+{
+
+// Subset of customers, bit i standing for customer i+1 (the depot is never in a subset)
+using CustomerMask = uint32_t;
+
+// Every table below has one entry per subset of customers, so this bounds their memory
+constexpr int MAX_DP_CUSTOMERS = 24;
+
+// Sum of two costs where either may be NO_ROAD
+inline Cost addCosts(Cost a, Cost b)
+{
+    return (a == NO_ROAD || b == NO_ROAD) ? NO_ROAD : a + b;
+}
+
+class CapacitatedVehicleRoutingProblem : public Solver
+{
+    public:
+    Solution bestRoute;
+    bool stoppedByBudget = false;
+
+    explicit CapacitatedVehicleRoutingProblem(const Problem& problem)
+        : numberOfPlaces(problem.numberOfPlaces), numberOfCustomers(problem.numberOfPlaces - 1), vehicleCapacity(problem.vehicleCapacity),
+          maxNumberOfPlacesPerRoute(problem.maxNumberOfPlacesPerRoute), roads(problem.roads), placesDemand(problem.placesDemand) {}
+
+    // The tables only give a route once they are complete, so a greedy route is built
+    // first and returned if `budget` runs out before. A unit of work is one subset.
+    void solve(SearchBudget& budget) override
+    {
+        this->budget = &budget;
+        buildGreedyRoute();
+        groupSubsetsByLayer();
+        findPredecessors();
+        computeCheapestTrips();
+        partitionIntoTrips();
+        if (!budget.exhausted())
+            buildBestRoute();
+        stoppedByBudget = budget.exhausted();
+    }
+
+    Solution solution() const override
+    {
+        return bestRoute;
+    }
+
+    std::string details() const override
+    {
+        return stoppedByBudget ? "Stopped by the budget: greedy route, not proven optimal\n" : "";
+    }
+
+    private:
+    int numberOfPlaces;
+    int numberOfCustomers;
+    int vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    const RoadMatrix& roads;
+    const std::vector<Load>& placesDemand;
+    SearchBudget* budget = nullptr;
+
+    // Reading the clock costs more than a subset, so subsets are charged in batches
+    static constexpr size_t subsetsPerBudgetCheck = 4096;
+
+    // Every subset sorted by size, with layerOffset[k] the position of the first subset
+    // of size k and layerIndex[subset] its position within its own layer.
+    std::vector<CustomerMask> subsetsByLayer;
+    std::vector<size_t> layerOffset;
+    std::vector<uint32_t> layerIndex;
+
+    // pathCost[k][layerIndex[subset] * numberOfCustomers + last] is the cheapest path that
+    // leaves the depot, visits exactly the k customers of `subset` and stops at `last`.
+    // Only layers up to maxNumberOfPlacesPerRoute are ever built.
+    std::vector<std::vector<Cost>> pathCost;
+
+    // Cheapest single-vehicle trip serving exactly each subset, NO_ROAD when infeasible
+    std::vector<Cost> tripCost;
+
+    // Cheapest way to serve each subset with several trips, and the trip holding its
+    // lowest customer in that solution
+    std::vector<Cost> partitionCost;
+    std::vector<CustomerMask> partitionTrip;
+
+    // Customers with a road into each customer, from the neighbour index. A path only
+    // extends through these, so missing roads are never looked at.
+    std::vector<CustomerMask> predecessors;
+
+    // Feasible trips grouped by their lowest customer
+    std::vector<std::vector<CustomerMask>> tripsByLowestCustomer;
+
+    static Place customerPlace(int customer)
+    {
+        return customer + 1;
+    }
+
+    static int lowestCustomer(CustomerMask subset)
+    {
+        return __builtin_ctz(subset);
+    }
+
+    // Nearest-neighbour giant tour cut into trips by the optimal split
+    void buildGreedyRoute()
+    {
+        NeighbourIndex neighbourIndex(roads);
+        GraspConstruction greedy(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute, 0.0, neighbourIndex);
+        GiantTourSplit split(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute);
+        RandomGenerator random;
+
+        std::vector<Place> giantTour;
+        std::vector<Place> route;
+        if (!greedy.constructGiantTour(random, giantTour))
+            return;
+
+        Cost cost = split.split(giantTour, route);
+        if (cost == NO_ROAD)
+            return;
+
+        bestRoute = Solution(route, cost);
+        budget->improved(cost);
+    }
+
+    // Whether the layer loops must stop; charges the budget once every batch of subsets
+    bool outOfBudget(size_t position) const
+    {
+        if (position % subsetsPerBudgetCheck == 0)
+            budget->spend(subsetsPerBudgetCheck);
+        return budget->exhausted();
+    }
+
+    void groupSubsetsByLayer()
+    {
+        CustomerMask numberOfSubsets = CustomerMask(1) << numberOfCustomers;
+
+        std::vector<size_t> layerSize(numberOfCustomers + 2, 0);
+        for (CustomerMask subset = 0; subset < numberOfSubsets; ++subset)
+            layerSize[__builtin_popcount(subset)]++;
+
+        layerOffset.assign(numberOfCustomers + 2, 0);
+        for (int size = 1; size <= numberOfCustomers + 1; ++size)
+            layerOffset[size] = layerOffset[size - 1] + layerSize[size - 1];
+
+        subsetsByLayer.resize(numberOfSubsets);
+        layerIndex.resize(numberOfSubsets);
+        std::vector<size_t> nextPosition(layerOffset.begin(), layerOffset.end());
+        for (CustomerMask subset = 0; subset < numberOfSubsets; ++subset)
+        {
+            int size = __builtin_popcount(subset);
+            layerIndex[subset] = static_cast<uint32_t>(nextPosition[size] - layerOffset[size]);
+            subsetsByLayer[nextPosition[size]++] = subset;
+        }
+    }
+
+    void findPredecessors()
+    {
+        NeighbourIndex neighbourIndex(roads);
+        predecessors.assign(numberOfCustomers, 0);
+
+        for (int customer = 0; customer < numberOfCustomers; ++customer)
+        {
+            for (const Neighbour& road : neighbourIndex.of(customerPlace(customer)))
+            {
+                if (road.place != 0)
+                    predecessors[road.place - 1] |= CustomerMask(1) << customer;
+            }
+        }
+    }
+
+    // Held-Karp over paths from the depot, one layer of subset sizes at a time. All
+    // subsets of a layer only read the previous layer, so each layer runs in parallel.
+    void computeCheapestTrips()
+    {
+        CustomerMask numberOfSubsets = CustomerMask(1) << numberOfCustomers;
+        int maxTripSize = std::min(maxNumberOfPlacesPerRoute, numberOfCustomers);
+
+        tripCost.assign(numberOfSubsets, NO_ROAD);
+        pathCost.assign(maxTripSize + 1, {});
+
+        for (int size = 1; size <= maxTripSize; ++size)
+        {
+            size_t layerBegin = layerOffset[size];
+            size_t layerEnd = layerOffset[size + 1];
+            std::vector<Cost>& layer = pathCost[size];
+            const std::vector<Cost>& previousLayer = pathCost[size - 1];
+            layer.assign((layerEnd - layerBegin) * numberOfCustomers, NO_ROAD);
+
+            #pragma omp parallel for schedule(static)
+            for (size_t position = layerBegin; position < layerEnd; ++position)
+            {
+                if (outOfBudget(position))
+                    continue;
+
+                CustomerMask subset = subsetsByLayer[position];
+
+                // Stops once over the capacity, so the sum stays within a Load
+                Load load = 0;
+                for (CustomerMask rest = subset; rest && load <= vehicleCapacity; rest &= rest - 1)
+                    load += placesDemand[customerPlace(lowestCustomer(rest))];
+                if (load > vehicleCapacity)
+                    continue;
+
+                Cost* paths = &layer[layerIndex[subset] * static_cast<size_t>(numberOfCustomers)];
+                Cost cheapestTrip = NO_ROAD;
+
+                for (CustomerMask lasts = subset; lasts; lasts &= lasts - 1)
+                {
+                    int last = lowestCustomer(lasts);
+                    CustomerMask withoutLast = subset & ~(CustomerMask(1) << last);
+                    Cost cheapestPath = NO_ROAD;
+
+                    if (withoutLast == 0)
+                    {
+                        cheapestPath = roads.cost(0, customerPlace(last));
+                    } else {
+                        const Cost* previousPaths = &previousLayer[layerIndex[withoutLast] * static_cast<size_t>(numberOfCustomers)];
+                        for (CustomerMask previous = withoutLast & predecessors[last]; previous; previous &= previous - 1)
+                        {
+                            int previousCustomer = lowestCustomer(previous);
+                            Cost cost = addCosts(previousPaths[previousCustomer], roads.cost(customerPlace(previousCustomer), customerPlace(last)));
+                            cheapestPath = std::min(cheapestPath, cost);
+                        }
+                    }
+
+                    paths[last] = cheapestPath;
+                    cheapestTrip = std::min(cheapestTrip, addCosts(cheapestPath, roads.cost(customerPlace(last), 0)));
+                }
+
+                tripCost[subset] = cheapestTrip;
+            }
+
+            if (budget->exhausted())
+                return;
+        }
+
+        tripsByLowestCustomer.assign(numberOfCustomers, {});
+        for (size_t position = layerOffset[1]; position < layerOffset[maxTripSize + 1]; ++position)
+        {
+            CustomerMask subset = subsetsByLayer[position];
+            if (tripCost[subset] != NO_ROAD)
+                tripsByLowestCustomer[lowestCustomer(subset)].push_back(subset);
+        }
+    }
+
+    // Set-partition DP: the trip serving the lowest customer of a subset is tried among
+    // every feasible trip that contains it. Subsets of one size only read smaller ones.
+    void partitionIntoTrips()
+    {
+        if (budget->exhausted())
+            return;
+
+        CustomerMask numberOfSubsets = CustomerMask(1) << numberOfCustomers;
+
+        partitionCost.assign(numberOfSubsets, NO_ROAD);
+        partitionTrip.assign(numberOfSubsets, 0);
+        partitionCost[0] = 0;
+
+        for (int size = 1; size <= numberOfCustomers; ++size)
+        {
+            size_t layerBegin = layerOffset[size];
+            size_t layerEnd = layerOffset[size + 1];
+
+            #pragma omp parallel for schedule(dynamic, 1024)
+            for (size_t position = layerBegin; position < layerEnd; ++position)
+            {
+                if (outOfBudget(position))
+                    continue;
+
+                CustomerMask subset = subsetsByLayer[position];
+                Cost cheapest = NO_ROAD;
+                CustomerMask cheapestTrip = 0;
+
+                for (CustomerMask trip : tripsByLowestCustomer[lowestCustomer(subset)])
+                {
+                    if ((trip & subset) != trip)
+                        continue;
+
+                    Cost cost = addCosts(partitionCost[subset & ~trip], tripCost[trip]);
+                    if (cost < cheapest)
+                    {
+                        cheapest = cost;
+                        cheapestTrip = trip;
+                    }
+                }
+
+                partitionCost[subset] = cheapest;
+                partitionTrip[subset] = cheapestTrip;
+            }
+
+            if (budget->exhausted())
+                return;
+        }
+    }
+
+    // Order of the customers of a trip, recovered by walking the path table backwards
+    std::vector<Place> tripPlaces(CustomerMask trip) const
+    {
+        std::vector<Place> places;
+        Cost remainingCost = tripCost[trip];
+        Place nextPlace = 0;
+
+        while (trip)
+        {
+            int size = __builtin_popcount(trip);
+            const Cost* paths = &pathCost[size][layerIndex[trip] * static_cast<size_t>(numberOfCustomers)];
+
+            for (CustomerMask lasts = trip; lasts; lasts &= lasts - 1)
+            {
+                int last = lowestCustomer(lasts);
+                if (addCosts(paths[last], roads.cost(customerPlace(last), nextPlace)) == remainingCost)
+                {
+                    places.push_back(customerPlace(last));
+                    remainingCost = paths[last];
+                    nextPlace = customerPlace(last);
+                    trip &= ~(CustomerMask(1) << last);
+                    break;
+                }
+            }
+        }
+
+        std::reverse(places.begin(), places.end());
+        return places;
+    }
+
+    void buildBestRoute()
+    {
+        CustomerMask everyCustomer = (CustomerMask(1) << numberOfCustomers) - 1;
+        Cost cost = partitionCost[everyCustomer];
+        if (cost == NO_ROAD)
+            return;
+        budget->improved(cost);
+
+        bestRoute = Solution({0}, cost);
+        for (CustomerMask remaining = everyCustomer; remaining; remaining &= ~partitionTrip[remaining])
+        {
+            for (Place place : tripPlaces(partitionTrip[remaining]))
+                bestRoute.places.push_back(place);
+            bestRoute.places.push_back(0);
+        }
+    }
+};
+
+} // namespace dynamic_programming_search
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "problem.h"
+#include "budget.h"
+#include "random.h"
+#include "neighbours.h"
+#include "grasp.h"
+#include "solver.h"
+#include "split.h"
+#include "improvement.h"
+
+namespace genetic_search
+{
+
+// One solution of the population. The giant tour is its genome; the route is the giant
+// tour after split and local search, and the giant tour is read back from that route so
+// both always describe the same solution.
+struct Individual
+{
+    Route giantTour;
+    Route route;
+    Cost cost = NO_ROAD;
+    std::vector<Place> successor;  // Place that follows each customer in the route
+    double biasedFitness = 0;
+};
+
+// Steady-state hybrid genetic algorithm in the spirit of HGS. Parents are picked by binary
+// tournament, recombined with order crossover on their giant tours and the child is
+// decoded by the optimal split and educated by the local search. Survivors are chosen on
+// a biased fitness that ranks both the cost and the contribution to diversity, measured
+// by the broken-pairs distance, so the population does not collapse onto one solution.
+//
+// Each generation breeds a batch of children from the same population in parallel with
+// OpenMP. Every child draws from its own generator seeded by its index, and children are
+// inserted in index order, so the result does not depend on the number of threads.
+class CapacitatedVehicleRoutingProblem : public Solver
+{
+    public:
+    Route bestRoute;
+    Cost lowerCost = INT_MAX;
+    int generationsRun = 0;
+
+    CapacitatedVehicleRoutingProblem(
+        const Problem& problem,
+        uint64_t seed,
+        int populationSize = 25,
+        int generationSize = 40,
+        int childrenPerGeneration = 32,
+        int maxGenerations = 500,
+        int maxGenerationsWithoutImprovement = 100
+    ) : numberOfPlaces(problem.numberOfPlaces), vehicleCapacity(problem.vehicleCapacity), maxNumberOfPlacesPerRoute(problem.maxNumberOfPlacesPerRoute),
+        placesDemand(problem.placesDemand), roads(problem.roads), seed(seed), populationSize(populationSize), generationSize(generationSize),
+        childrenPerGeneration(childrenPerGeneration), maxGenerations(maxGenerations),
+        maxGenerationsWithoutImprovement(maxGenerationsWithoutImprovement) {}
+
+    // Evolves until maxGenerations, a stall, or `budget` is exhausted. A unit of work is
+    // one generation; the clock is also checked before each child, so a generation cut
+    // short only inserts the children already educated.
+    void solve(SearchBudget& budget) override
+    {
+        this->budget = &budget;
+        neighbourIndex = NeighbourIndex(roads);
+        GraspConstruction grasp(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute, initialGraspAlpha, neighbourIndex);
+        GiantTourSplit split(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute);
+
+        population.clear();
+        uint64_t nextChild = 0;
+
+        // Initial population from random GRASP giant tours
+        std::vector<Individual> batch(4 * populationSize);
+        #pragma omp parallel
+        {
+            RouteImprovement improvement(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute);
+
+            #pragma omp for schedule(dynamic, 1)
+            for (int i = 0; i < static_cast<int>(batch.size()); ++i)
+            {
+                RandomGenerator random = RandomGenerator::forIteration(seed, nextChild + i);
+                if (grasp.constructGiantTour(random, batch[i].giantTour))
+                    educate(batch[i], split, improvement);
+            }
+        }
+        nextChild += batch.size();
+        insertBatch(batch);
+
+        int generationsWithoutImprovement = 0;
+        for (generationsRun = 0; generationsRun < maxGenerations; ++generationsRun)
+        {
+            if (population.size() < 2 || generationsWithoutImprovement >= maxGenerationsWithoutImprovement)
+                break;
+            if (!budget.spend())
+                break;
+
+            computeDistances();
+            updateBiasedFitness();
+            batch.assign(childrenPerGeneration, Individual());
+
+            #pragma omp parallel
+            {
+                RouteImprovement improvement(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute);
+
+                #pragma omp for schedule(dynamic, 1)
+                for (int i = 0; i < childrenPerGeneration; ++i)
+                {
+                    if (!budget.spend(0))
+                        continue;
+
+                    RandomGenerator random = RandomGenerator::forIteration(seed, nextChild + i);
+                    const Individual& firstParent = binaryTournament(random);
+                    const Individual& secondParent = binaryTournament(random);
+                    orderCrossover(random, firstParent.giantTour, secondParent.giantTour, batch[i].giantTour);
+                    educate(batch[i], split, improvement);
+                }
+            }
+            nextChild += childrenPerGeneration;
+
+            Cost costBefore = lowerCost;
+            insertBatch(batch);
+            generationsWithoutImprovement = lowerCost < costBefore ? 0 : generationsWithoutImprovement + 1;
+        }
+    }
+
+    Solution solution() const override
+    {
+        return Solution(bestRoute, lowerCost);
+    }
+
+    std::string details() const override
+    {
+        return "Generations: " + std::to_string(generationsRun) + "\n";
+    }
+
+    private:
+    int numberOfPlaces;
+    int vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    const std::vector<Load>& placesDemand;
+    const RoadMatrix& roads;
+    uint64_t seed;
+    int populationSize;
+    int generationSize;
+    int childrenPerGeneration;
+    int maxGenerations;
+    int maxGenerationsWithoutImprovement;
+    NeighbourIndex neighbourIndex;
+    SearchBudget* budget = nullptr;
+    std::vector<Individual> population;
+
+    // Broken-pairs distance between every two individuals of the population
+    std::vector<std::vector<double>> distances;
+
+    // The initial giant tours are uniformly random among the feasible roads
+    static constexpr double initialGraspAlpha = 1.0;
+
+    // Individuals counted as close neighbours when measuring the diversity contribution
+    static constexpr int numberOfCloseIndividuals = 5;
+
+    // Best individuals whose biased fitness is dominated by their cost
+    static constexpr int numberOfEliteIndividuals = 4;
+
+    // Split, improve and read the giant tour back, leaving cost NO_ROAD when infeasible
+    void educate(Individual& individual, const GiantTourSplit& split, RouteImprovement& improvement) const
+    {
+        individual.cost = split.split(individual.giantTour, individual.route);
+        if (individual.cost == NO_ROAD)
+            return;
+
+        individual.cost = improvement.improve(individual.route, individual.cost);
+        individual.giantTour = GiantTourSplit::giantTourOf(individual.route);
+
+        individual.successor.assign(numberOfPlaces, 0);
+        for (size_t k = 1; k + 1 < individual.route.size(); ++k)
+        {
+            if (individual.route[k] != 0)
+                individual.successor[individual.route[k]] = individual.route[k + 1];
+        }
+    }
+
+    // Order crossover (OX): the child keeps a random slice of the first parent in place
+    // and takes the other customers in the order they appear in the second parent,
+    // starting right after the slice.
+    static void orderCrossover(RandomGenerator& random, const Route& firstParent, const Route& secondParent, Route& child)
+    {
+        int length = firstParent.size();
+        int sliceBegin = random.nextBelow(length);
+        int sliceEnd = random.nextBelow(length);
+        if (sliceEnd < sliceBegin)
+            std::swap(sliceBegin, sliceEnd);
+
+        int numberOfPlaces = length + 1;
+        std::vector<bool> taken(numberOfPlaces, false);
+        child.assign(length, 0);
+        for (int position = sliceBegin; position <= sliceEnd; ++position)
+        {
+            child[position] = firstParent[position];
+            taken[firstParent[position]] = true;
+        }
+
+        int position = (sliceEnd + 1) % length;
+        for (int k = 0; k < length; ++k)
+        {
+            Place place = secondParent[(sliceEnd + 1 + k) % length];
+            if (taken[place])
+                continue;
+
+            child[position] = place;
+            position = (position + 1) % length;
+        }
+    }
+
+    // Share of customers followed by a different place in the two solutions
+    double brokenPairsDistance(const Individual& a, const Individual& b) const
+    {
+        int brokenPairs = 0;
+        for (Place place = 1; place < numberOfPlaces; ++place)
+            brokenPairs += a.successor[place] != b.successor[place];
+        return static_cast<double>(brokenPairs) / (numberOfPlaces - 1);
+    }
+
+    void computeDistances()
+    {
+        int size = population.size();
+        distances.assign(size, std::vector<double>(size, 0));
+        for (int i = 0; i < size; ++i)
+        {
+            for (int other = i + 1; other < size; ++other)
+                distances[i][other] = distances[other][i] = brokenPairsDistance(population[i], population[other]);
+        }
+    }
+
+    void removeIndividual(int index)
+    {
+        population.erase(population.begin() + index);
+        distances.erase(distances.begin() + index);
+        for (std::vector<double>& row : distances)
+            row.erase(row.begin() + index);
+    }
+
+    // Average distance to the closest individuals of the population
+    double diversityContribution(int index) const
+    {
+        std::vector<double> others;
+        for (int other = 0; other < static_cast<int>(population.size()); ++other)
+        {
+            if (other != index)
+                others.push_back(distances[index][other]);
+        }
+
+        int closest = std::min<int>(numberOfCloseIndividuals, others.size());
+        if (closest == 0)
+            return 0;
+
+        std::partial_sort(others.begin(), others.begin() + closest, others.end());
+        double total = 0;
+        for (int k = 0; k < closest; ++k)
+            total += others[k];
+        return total / closest;
+    }
+
+    // Biased fitness = cost rank + (1 - elite share) * diversity rank, both normalised to
+    // [0, 1]. Lower is better. Needs the distances of the current population.
+    void updateBiasedFitness()
+    {
+        int size = population.size();
+        if (size == 1)
+        {
+            population[0].biasedFitness = 0;
+            return;
+        }
+
+        std::vector<double> diversity(size);
+        for (int i = 0; i < size; ++i)
+            diversity[i] = diversityContribution(i);
+
+        std::vector<int> byCost(size);
+        std::vector<int> byDiversity(size);
+        for (int i = 0; i < size; ++i)
+            byCost[i] = byDiversity[i] = i;
+        std::stable_sort(byCost.begin(), byCost.end(), [this](int a, int b) {
+            return population[a].cost < population[b].cost;
+        });
+        std::stable_sort(byDiversity.begin(), byDiversity.end(), [&diversity](int a, int b) {
+            return diversity[a] > diversity[b];
+        });
+
+        std::vector<double> diversityRank(size);
+        for (int rank = 0; rank < size; ++rank)
+            diversityRank[byDiversity[rank]] = static_cast<double>(rank) / (size - 1);
+
+        double diversityWeight = 1.0 - static_cast<double>(numberOfEliteIndividuals) / size;
+        for (int rank = 0; rank < size; ++rank)
+        {
+            Individual& individual = population[byCost[rank]];
+            individual.biasedFitness = static_cast<double>(rank) / (size - 1) + diversityWeight * diversityRank[byCost[rank]];
+        }
+    }
+
+    const Individual& binaryTournament(RandomGenerator& random) const
+    {
+        const Individual& first = population[random.nextBelow(population.size())];
+        const Individual& second = population[random.nextBelow(population.size())];
+        return first.biasedFitness <= second.biasedFitness ? first : second;
+    }
+
+    void insertBatch(std::vector<Individual>& batch)
+    {
+        for (Individual& individual : batch)
+        {
+            if (individual.cost == NO_ROAD)
+                continue;
+
+            if (individual.cost < lowerCost)
+            {
+                lowerCost = individual.cost;
+                bestRoute = individual.route;
+                budget->improved(lowerCost);
+            }
+
+            population.push_back(std::move(individual));
+            if (static_cast<int>(population.size()) >= populationSize + generationSize)
+                selectSurvivors();
+        }
+    }
+
+    // Removes clones first, then the individuals with the worst biased fitness, until
+    // the population is back to its nominal size
+    void selectSurvivors()
+    {
+        computeDistances();
+
+        while (static_cast<int>(population.size()) > populationSize)
+        {
+            updateBiasedFitness();
+
+            int removed = -1;
+            bool removedIsClone = false;
+            for (int i = 0; i < static_cast<int>(population.size()); ++i)
+            {
+                bool isClone = false;
+                for (int other = 0; other < static_cast<int>(population.size()) && !isClone; ++other)
+                    isClone = other != i && distances[i][other] == 0;
+
+                bool worse = removed < 0 || (isClone && !removedIsClone)
+                    || (isClone == removedIsClone && population[i].biasedFitness > population[removed].biasedFitness);
+                if (worse)
+                {
+                    removed = i;
+                    removedIsClone = isClone;
+                }
+            }
+
+            removeIndividual(removed);
+        }
+    }
+};
+
+} // namespace genetic_search
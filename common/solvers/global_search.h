@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <vector>
+
+#include "problem.h"
+#include "best_routes.h"
+#include "solver.h"
+#include "budget.h"
+#include "instrumentation.h"
+#include "neighbours.h"
+
+namespace global_search
+{
+
+struct SearchStatistics
+{
+    long long nodesExpanded = 0;
+    long long heapAllocations = 0; // Only counted with CVRP_INSTRUMENTATION
+};
+
+enum class SearchMode
+{
+    Exhaustive,     // Visit every feasible tour once, folding each one into the best routes
+    BranchAndBound  // Also cut partial routes that cannot beat the kept routes
+};
+
+class CapacitatedVehicleRoutingProblem : public Solver
+{
+    public:
+    Solution bestRoute;
+    std::vector<Solution> topRoutes;
+    SearchStatistics statistics;
+    bool stoppedByBudget = false;
+
+    CapacitatedVehicleRoutingProblem(
+        const Problem& problem,
+        SearchMode searchMode = SearchMode::Exhaustive,
+        int numberOfBestRoutes = 1
+    ) : numberOfPlaces(problem.numberOfPlaces), vehicleCapacity(problem.vehicleCapacity), maxNumberOfPlacesPerRoute(problem.maxNumberOfPlacesPerRoute), roads(problem.roads), placesDemand(problem.placesDemand), searchMode(searchMode), bestRoutes(numberOfBestRoutes) {}
+
+    // Stops early, keeping the best routes found so far, once `budget` is exhausted.
+    // A unit of work is one node.
+    void solve(SearchBudget& budget) override
+    {
+        this->budget = &budget;
+
+        // Every route alternates customers and depot returns, so it never holds more
+        // than two entries per customer plus the starting depot.
+        state.route = Solution({0}, 0);
+        state.route.places.reserve(2 * numberOfPlaces);
+        state.placesVisited = placeBit(0);
+
+        neighbourIndex = NeighbourIndex(roads);
+        computeCheapestOutgoingRoads();
+
+        long long allocationsBeforeSearch = instrumentation::heapAllocationCount();
+        generateAllRouteCombinationsWithRestrictions(0, 0, 0, 0);
+        statistics.heapAllocations = instrumentation::heapAllocationCount() - allocationsBeforeSearch;
+
+        topRoutes = bestRoutes.sorted();
+        if (!topRoutes.empty())
+            bestRoute = topRoutes.front();
+        stoppedByBudget = budget.exhausted();
+    }
+
+    Solution solution() const override
+    {
+        return bestRoute;
+    }
+
+    std::string details() const override
+    {
+        std::string lines = "Nodes expanded: " + std::to_string(statistics.nodesExpanded);
+        // Allocations are only counted in an instrumented build
+        if constexpr (instrumentation::enabled)
+            lines += " (" + std::to_string(statistics.heapAllocations) + " heap allocations)";
+        lines += "\n";
+        if (stoppedByBudget)
+            lines += "Stopped by the budget: best route found so far, not proven optimal\n";
+        return lines;
+    }
+
+    private:
+    // Mutable state of the depth-first search. It is shared by every recursive call
+    // and restored by undoing each move on the way back, so no node copies it.
+    struct SearchState
+    {
+        Solution route = Solution({}, 0);
+        PlaceMask placesVisited = 0;
+        Cost unvisitedLowerBound = 0;
+    };
+
+    int numberOfPlaces;
+    int vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    const RoadMatrix& roads;
+    NeighbourIndex neighbourIndex;
+    const std::vector<Load>& placesDemand;
+    SearchMode searchMode;
+    BestRoutes bestRoutes;
+    SearchState state;
+    SearchBudget* budget = nullptr;
+
+    // Reading the clock costs more than a node, so nodes are charged in batches
+    static constexpr long long nodesPerBudgetCheck = 1024;
+
+    // Cheapest road leaving each place, used as an admissible lower bound:
+    // every place not yet visited must still be left exactly once.
+    std::vector<Cost> cheapestOutgoingRoad;
+
+    void computeCheapestOutgoingRoads()
+    {
+        cheapestOutgoingRoad.assign(numberOfPlaces, 0);
+        state.unvisitedLowerBound = 0;
+
+        for (Place place = 0; place < numberOfPlaces; ++place)
+        {
+            // The index is sorted, so the cheapest road comes first
+            Cost cheapest = neighbourIndex.degree(place) > 0 ? neighbourIndex.at(place, 0).cost : NO_ROAD;
+            if (cheapest == NO_ROAD)
+                cheapest = 0;
+
+            cheapestOutgoingRoad[place] = cheapest;
+            if (place != 0)
+                state.unvisitedLowerBound += cheapest;
+        }
+    }
+
+    void visitPlace(Place place, Cost roadCost)
+    {
+        state.route.cost += roadCost;
+        state.route.places.push_back(place);
+        state.placesVisited |= placeBit(place);
+        if (place != 0)
+            state.unvisitedLowerBound -= cheapestOutgoingRoad[place];
+    }
+
+    void undoVisitPlace(Place place, Cost roadCost)
+    {
+        // The depot stays visited: it was already in the set before the move
+        if (place != 0)
+        {
+            state.placesVisited &= ~placeBit(place);
+            state.unvisitedLowerBound += cheapestOutgoingRoad[place];
+        }
+        state.route.places.pop_back();
+        state.route.cost -= roadCost;
+    }
+
+    // `tripStart` is the first customer of the current trip, or of the last one when the
+    // vehicle is at the depot. Reordering the trips of a tour leaves its cost unchanged, so
+    // each tour is only generated once, with its trips ordered by their first customer.
+    void generateAllRouteCombinationsWithRestrictions(
+        int numberOfPlacesVisited,
+        Place previousPlace,
+        Load vehicleLoad,
+        Place tripStart
+    )
+    {
+        statistics.nodesExpanded++;
+        instrumentation::count(instrumentation::NodesExpanded);
+        if (statistics.nodesExpanded % nodesPerBudgetCheck == 0)
+            budget->spend(nodesPerBudgetCheck);
+        if (budget->exhausted())
+            return;
+
+        const PlaceMask everyPlace = allPlacesMask(numberOfPlaces);
+
+        // Only existing roads, cheapest first, so good tours are found early
+        for (const Neighbour& road : neighbourIndex.of(previousPlace))
+        {
+            Place currentPlace = road.place;
+            Cost roadCost = road.cost;
+
+            // Filter places already visited
+            if ((state.placesVisited & placeBit(currentPlace)) && currentPlace != 0)
+                continue;
+
+            // A new trip must start after the previous one
+            if (numberOfPlacesVisited == 0 && currentPlace <= tripStart)
+                continue;
+
+            if (currentPlace != 0)
+            {
+                bool loadExceeded = (vehicleLoad+placesDemand[currentPlace]) > vehicleCapacity;
+                bool placesExceeded = (numberOfPlacesVisited+1) > maxNumberOfPlacesPerRoute;
+                if (loadExceeded || placesExceeded)
+                    continue;
+            }
+
+            bool closesTour = currentPlace == 0 && state.placesVisited == everyPlace;
+
+            if (searchMode == SearchMode::BranchAndBound)
+            {
+                // Unless this move closes the tour, the current place must still be left once more
+                Cost remainingLowerBound = state.unvisitedLowerBound;
+                if (currentPlace != 0)
+                    remainingLowerBound -= cheapestOutgoingRoad[currentPlace];
+                if (!closesTour)
+                    remainingLowerBound += cheapestOutgoingRoad[currentPlace];
+
+                if (state.route.cost + roadCost + remainingLowerBound >= bestRoutes.worstKeptCost())
+                {
+                    instrumentation::count(instrumentation::NodesPruned);
+                    continue;
+                }
+            }
+
+            visitPlace(currentPlace, roadCost);
+
+            if (closesTour)
+            {
+                bestRoutes.offer(state.route);
+                instrumentation::count(instrumentation::RoutesCompleted);
+                budget->improved(state.route.cost);
+                undoVisitPlace(currentPlace, roadCost);
+                return;
+            }
+
+            if (currentPlace == 0)
+                generateAllRouteCombinationsWithRestrictions(0, currentPlace, 0, tripStart);
+            else
+                generateAllRouteCombinationsWithRestrictions(
+                    numberOfPlacesVisited+1,
+                    currentPlace,
+                    vehicleLoad+placesDemand[currentPlace],
+                    numberOfPlacesVisited == 0 ? currentPlace : tripStart
+                );
+
+            undoVisitPlace(currentPlace, roadCost);
+        }
+    }
+};
+
+} // namespace global_search
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <climits>
+#include <vector>
+
+#include "problem.h"
+#include "budget.h"
+#include "random.h"
+#include "construction.h"
+#include "improvement.h"
+#include "instrumentation.h"
+#include "neighbours.h"
+#include "solver.h"
+
+namespace local_search
+{
+
+class CapacitatedVehicleRoutingProblem : public Solver
+{
+    public:
+    Route bestRoute;
+    Cost lowerCost = INT_MAX;
+
+    CapacitatedVehicleRoutingProblem(
+        const Problem& problem,
+        uint64_t seed,
+        ConstructionMode constructionMode = ConstructionMode::RandomizedGreedy,
+        double graspAlpha = 0.3,
+        int iterations = 10000,
+        bool improveRoutes = false,
+        int maxNeighbours = 0,
+        ImprovementMode improvementMode = ImprovementMode::Descent,
+        int improvementSteps = 0
+    ) : numberOfPlaces(problem.numberOfPlaces), vehicleCapacity(problem.vehicleCapacity), maxNumberOfPlacesPerRoute(problem.maxNumberOfPlacesPerRoute), placesDemand(problem.placesDemand), roads(problem.roads), seed(seed), constructionMode(constructionMode), graspAlpha(graspAlpha), iterations(iterations), improveRoutes(improveRoutes), maxNeighbours(maxNeighbours), improvementMode(improvementMode), improvementSteps(improvementSteps) {}
+
+    // Runs until `iterations` constructions are done or `budget` is exhausted. A unit of
+    // work is one construction.
+    void solve(SearchBudget& budget) override
+    {
+        this->budget = &budget;
+        neighbourIndex = NeighbourIndex(roads, maxNeighbours);
+        RouteConstruction construction(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute, constructionMode, graspAlpha, neighbourIndex);
+        RouteImprovement improvement(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute);
+
+        for (int i = 0; i < iterations && budget.spend(); ++i)
+        {
+            RandomGenerator random = RandomGenerator::forIteration(seed, i);
+            std::pair<Route, Cost> result = construction.construct(random);
+            if (result.second != NO_ROAD)
+                instrumentation::count(instrumentation::RoutesCompleted);
+            if (improveRoutes && result.second != NO_ROAD)
+                result.second = improveRoute(random, improvement, result.first, result.second);
+            if (result.second < lowerCost)
+            {
+                bestRoute = result.first;
+                lowerCost = result.second;
+                budget.improved(lowerCost);
+            }
+        }
+    }
+
+    Solution solution() const override
+    {
+        return Solution(bestRoute, lowerCost);
+    }
+
+    private:
+    int numberOfPlaces;
+    int vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    const std::vector<Load>& placesDemand;
+    const RoadMatrix& roads;
+    uint64_t seed;
+    ConstructionMode constructionMode;
+    double graspAlpha;
+    int iterations;
+    bool improveRoutes;
+    int maxNeighbours;
+    ImprovementMode improvementMode;
+    int improvementSteps;
+    NeighbourIndex neighbourIndex;
+    SearchBudget* budget = nullptr;
+
+    Cost improveRoute(RandomGenerator& random, RouteImprovement& improvement, Route& route, Cost cost)
+    {
+        if (improvementMode == ImprovementMode::SimulatedAnnealing)
+            return improvement.anneal(route, cost, random, improvementSteps, budget);
+        if (improvementMode == ImprovementMode::TabuSearch)
+            return improvement.tabuSearch(route, cost, random, improvementSteps, budget);
+        return improvement.improve(route, cost);
+    }
+};
+
+} // namespace local_search
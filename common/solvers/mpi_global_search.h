@@ -0,0 +1,420 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include <mpi.h>
+
+#include "problem.h"
+#include "budget.h"
+#include "instrumentation.h"
+#include "neighbours.h"
+#include "solver.h"
+
+// Branch and bound split over MPI ranks and their OpenMP threads. Needs an MPI compiler,
+// so only the MPI drivers include it.
+namespace mpi_global_search
+{
+
+// A partial route from the depot, together with everything needed to keep extending it.
+// The frontier is a list of independent prefixes whose subtrees share no work.
+struct Prefix
+{
+    Solution route = Solution({}, 0);
+    PlaceMask placesVisited = 0;
+    int numberOfPlacesVisited = 0;
+    Load vehicleLoad = 0;
+    Cost unvisitedLowerBound = 0;
+    Place tripStart = 0; // First customer of the current trip, or of the last one at the depot
+};
+
+// One level of the explicit depth-first stack. `nextRoad` is the rank of the next road
+// to try among those leaving `previousPlace`, and `roadCost` is the cost of the move that
+// entered this level.
+struct SearchFrame
+{
+    Place previousPlace;
+    int numberOfPlacesVisited;
+    Load vehicleLoad;
+    Place tripStart;
+    int nextRoad;
+    Cost roadCost;
+};
+
+// Best route found by one thread, padded to a cache line so threads never share one
+struct alignas(64) ThreadBestRoute
+{
+    Solution route;
+    long long nodesExpanded = 0;
+};
+
+class CapacitatedVehicleRoutingProblem : public Solver
+{
+    public:
+    Solution bestRoute;
+    long long nodesExpanded = 0;
+    bool stoppedByBudget = false;
+    int world_rank;
+    int world_size;
+
+    CapacitatedVehicleRoutingProblem(
+        const Problem& problem,
+        int world_rank,
+        int world_size,
+        int prefixesPerWorker = 8,
+        int prefixesPerRound = 16
+    ) : world_rank(world_rank), world_size(world_size), numberOfPlaces(problem.numberOfPlaces), vehicleCapacity(problem.vehicleCapacity),
+        maxNumberOfPlacesPerRoute(problem.maxNumberOfPlacesPerRoute), roads(problem.roads), placesDemand(problem.placesDemand),
+        prefixesPerWorker(prefixesPerWorker), prefixesPerRound(prefixesPerRound) {}
+
+    // Stops early, keeping the best route found so far, once `budget` is exhausted. A unit
+    // of work is one node. Each rank charges its own budget but keeps taking part in the
+    // rounds, so the collective calls still match.
+    void solve(SearchBudget& budget) override
+    {
+        this->budget = &budget;
+        neighbourIndex = NeighbourIndex(roads);
+        computeCheapestOutgoingRoads();
+        incumbentCost.store(INT_MAX, std::memory_order_relaxed);
+        threadBestRoutes.assign(omp_get_max_threads(), ThreadBestRoute());
+
+        // Every rank expands the same frontier, so prefix i can be owned by rank
+        // i % world_size without sending any prefix over the network. Its size must not
+        // depend on the local thread count, which may differ between ranks.
+        int localThreads = omp_get_max_threads();
+        int threadsPerRank;
+        {
+            instrumentation::MpiWaitScope wait;
+            MPI_Allreduce(&localThreads, &threadsPerRank, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+        }
+        std::vector<Prefix> frontier = expandFrontier(threadsPerRank);
+
+        std::vector<int> localPrefixes;
+        for (int i = world_rank; i < static_cast<int>(frontier.size()); i += world_size)
+            localPrefixes.push_back(i);
+
+        int roundSize = prefixesPerRound * omp_get_max_threads();
+        int localRounds = (static_cast<int>(localPrefixes.size()) + roundSize - 1) / roundSize;
+        int rounds;
+        {
+            instrumentation::MpiWaitScope wait;
+            MPI_Allreduce(&localRounds, &rounds, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+        }
+
+        for (int round = 0; round < rounds; ++round)
+        {
+            int begin = std::min(round * roundSize, static_cast<int>(localPrefixes.size()));
+            int end = std::min(begin + roundSize, static_cast<int>(localPrefixes.size()));
+
+            #pragma omp parallel
+            {
+                instrumentation::RegionScope region;
+                #pragma omp for schedule(dynamic, 1)
+                for (int i = begin; i < end; ++i)
+                {
+                    instrumentation::BusyScope busy;
+                    searchFromPrefix(frontier[localPrefixes[i]], threadBestRoutes[omp_get_thread_num()]);
+                }
+            }
+
+            // Share the best cost between rounds so every rank prunes with it
+            Cost localIncumbent = incumbentCost.load(std::memory_order_relaxed);
+            Cost globalIncumbent;
+            {
+                instrumentation::MpiWaitScope wait;
+                MPI_Allreduce(&localIncumbent, &globalIncumbent, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+            }
+            updateIncumbent(globalIncumbent);
+            budget.improved(globalIncumbent);
+        }
+
+        for (auto const& threadBest : threadBestRoutes)
+        {
+            nodesExpanded += threadBest.nodesExpanded;
+            if (threadBest.route.cost < bestRoute.cost)
+                bestRoute = threadBest.route;
+        }
+
+        gatherBestRoute();
+    }
+
+    Solution solution() const override
+    {
+        return bestRoute;
+    }
+
+    std::string details() const override
+    {
+        std::string lines = "Nodes expanded: " + std::to_string(nodesExpanded) + "\n";
+        if (stoppedByBudget)
+            lines += "Stopped by the budget: best route found so far, not proven optimal\n";
+        return lines;
+    }
+
+    private:
+    int numberOfPlaces;
+    int vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    const RoadMatrix& roads;
+    NeighbourIndex neighbourIndex;
+    const std::vector<Load>& placesDemand;
+    int prefixesPerWorker;
+    int prefixesPerRound;
+    std::vector<ThreadBestRoute> threadBestRoutes;
+    std::atomic<Cost> incumbentCost{INT_MAX};
+    SearchBudget* budget = nullptr;
+
+    // Reading the clock costs more than a node, so nodes are charged in batches
+    static constexpr long long nodesPerBudgetCheck = 1024;
+
+    // Cheapest road leaving each place, used as an admissible lower bound:
+    // every place not yet visited must still be left exactly once.
+    std::vector<Cost> cheapestOutgoingRoad;
+
+    void computeCheapestOutgoingRoads()
+    {
+        cheapestOutgoingRoad.assign(numberOfPlaces, 0);
+
+        for (Place place = 0; place < numberOfPlaces; ++place)
+        {
+            // The index is sorted, so the cheapest road comes first
+            Cost cheapest = neighbourIndex.degree(place) > 0 ? neighbourIndex.at(place, 0).cost : NO_ROAD;
+            cheapestOutgoingRoad[place] = cheapest == NO_ROAD ? 0 : cheapest;
+        }
+    }
+
+    void updateIncumbent(Cost cost)
+    {
+        Cost incumbent = incumbentCost.load(std::memory_order_relaxed);
+        while (cost < incumbent && !incumbentCost.compare_exchange_weak(incumbent, cost, std::memory_order_relaxed));
+    }
+
+    void recordCompleteRoute(const Solution& route, ThreadBestRoute& threadBest)
+    {
+        if (route.cost >= threadBest.route.cost)
+            return;
+
+        threadBest.route.places.assign(route.places.begin(), route.places.end());
+        threadBest.route.cost = route.cost;
+        updateIncumbent(route.cost);
+        budget->improved(route.cost);
+    }
+
+    // Cost of taking `road`, or NO_ROAD when the place it reaches is already visited or
+    // does not fit in the vehicle. Reordering the trips of a tour leaves its cost unchanged,
+    // so each tour is only searched once, with its trips ordered by their first customer.
+    Cost moveCost(PlaceMask placesVisited, int numberOfPlacesVisited, Load vehicleLoad, Place tripStart, const Neighbour& road) const
+    {
+        Place currentPlace = road.place;
+        if (currentPlace != 0)
+        {
+            if (placesVisited & placeBit(currentPlace))
+                return NO_ROAD;
+
+            // A new trip must start after the previous one
+            if (numberOfPlacesVisited == 0 && currentPlace <= tripStart)
+                return NO_ROAD;
+
+            bool loadExceeded = (vehicleLoad+placesDemand[currentPlace]) > vehicleCapacity;
+            bool placesExceeded = (numberOfPlacesVisited+1) > maxNumberOfPlacesPerRoute;
+            if (loadExceeded || placesExceeded)
+                return NO_ROAD;
+        }
+
+        return road.cost;
+    }
+
+    // Unless a move closes the tour, the place it reaches must still be left once more
+    Cost remainingLowerBound(Cost unvisitedLowerBound, Place currentPlace, bool closesTour) const
+    {
+        Cost bound = unvisitedLowerBound;
+        if (currentPlace != 0)
+            bound -= cheapestOutgoingRoad[currentPlace];
+        if (!closesTour)
+            bound += cheapestOutgoingRoad[currentPlace];
+        return bound;
+    }
+
+    // Breadth-first expansion from the depot until there are enough independent prefixes
+    // to keep `threadsPerRank` threads of every rank busy. Tours completed on the way are
+    // recorded.
+    std::vector<Prefix> expandFrontier(int threadsPerRank)
+    {
+        const PlaceMask everyPlace = allPlacesMask(numberOfPlaces);
+        size_t targetSize = static_cast<size_t>(prefixesPerWorker) * world_size * threadsPerRank;
+
+        Prefix root;
+        root.route = Solution({0}, 0);
+        root.placesVisited = placeBit(0);
+        for (Place place = 1; place < numberOfPlaces; ++place)
+            root.unvisitedLowerBound += cheapestOutgoingRoad[place];
+
+        std::vector<Prefix> frontier = {root};
+        std::vector<Prefix> nextFrontier;
+
+        while (!frontier.empty() && frontier.size() < targetSize)
+        {
+            nextFrontier.clear();
+
+            for (auto const& prefix : frontier)
+            {
+                Place previousPlace = prefix.route.places.back();
+
+                for (const Neighbour& road : neighbourIndex.of(previousPlace))
+                {
+                    Place currentPlace = road.place;
+                    Cost roadCost = moveCost(prefix.placesVisited, prefix.numberOfPlacesVisited, prefix.vehicleLoad, prefix.tripStart, road);
+                    if (roadCost == NO_ROAD)
+                        continue;
+
+                    bool closesTour = currentPlace == 0 && prefix.placesVisited == everyPlace;
+                    Cost bound = remainingLowerBound(prefix.unvisitedLowerBound, currentPlace, closesTour);
+                    if (prefix.route.cost + roadCost + bound >= incumbentCost.load(std::memory_order_relaxed))
+                        continue;
+
+                    Prefix child = prefix;
+                    child.route.places.push_back(currentPlace);
+                    child.route.cost += roadCost;
+
+                    if (closesTour)
+                    {
+                        recordCompleteRoute(child.route, threadBestRoutes[0]);
+                        break;
+                    }
+
+                    child.placesVisited |= placeBit(currentPlace);
+                    child.numberOfPlacesVisited = currentPlace == 0 ? 0 : prefix.numberOfPlacesVisited+1;
+                    child.vehicleLoad = currentPlace == 0 ? 0 : prefix.vehicleLoad+placesDemand[currentPlace];
+                    if (prefix.numberOfPlacesVisited == 0 && currentPlace != 0)
+                        child.tripStart = currentPlace;
+                    if (currentPlace != 0)
+                        child.unvisitedLowerBound -= cheapestOutgoingRoad[currentPlace];
+                    nextFrontier.push_back(std::move(child));
+                }
+            }
+
+            frontier.swap(nextFrontier);
+        }
+
+        return frontier;
+    }
+
+    // Iterative depth-first branch and bound below one prefix. The route and the visited
+    // mask are updated in place and restored when a stack level is popped.
+    void searchFromPrefix(const Prefix& prefix, ThreadBestRoute& threadBest)
+    {
+        const PlaceMask everyPlace = allPlacesMask(numberOfPlaces);
+
+        Solution route = prefix.route;
+        route.places.reserve(2 * numberOfPlaces);
+        PlaceMask placesVisited = prefix.placesVisited;
+        Cost unvisitedLowerBound = prefix.unvisitedLowerBound;
+
+        std::vector<SearchFrame> stack;
+        stack.reserve(2 * numberOfPlaces);
+        stack.push_back({route.places.back(), prefix.numberOfPlacesVisited, prefix.vehicleLoad, prefix.tripStart, 0, 0});
+        threadBest.nodesExpanded++;
+        instrumentation::count(instrumentation::NodesExpanded);
+
+        while (!stack.empty() && !budget->exhausted())
+        {
+            SearchFrame& frame = stack.back();
+
+            if (frame.nextRoad == neighbourIndex.degree(frame.previousPlace))
+            {
+                // Undo the move that entered this level, except for the prefix itself
+                Place place = frame.previousPlace;
+                Cost roadCost = frame.roadCost;
+                stack.pop_back();
+                if (stack.empty())
+                    break;
+
+                if (place != 0)
+                {
+                    placesVisited &= ~placeBit(place);
+                    unvisitedLowerBound += cheapestOutgoingRoad[place];
+                }
+                route.places.pop_back();
+                route.cost -= roadCost;
+                continue;
+            }
+
+            const Neighbour& road = neighbourIndex.at(frame.previousPlace, frame.nextRoad++);
+            Place currentPlace = road.place;
+            Cost roadCost = moveCost(placesVisited, frame.numberOfPlacesVisited, frame.vehicleLoad, frame.tripStart, road);
+            if (roadCost == NO_ROAD)
+                continue;
+
+            bool closesTour = currentPlace == 0 && placesVisited == everyPlace;
+            Cost bound = remainingLowerBound(unvisitedLowerBound, currentPlace, closesTour);
+            if (route.cost + roadCost + bound >= incumbentCost.load(std::memory_order_relaxed))
+            {
+                instrumentation::count(instrumentation::NodesPruned);
+                continue;
+            }
+
+            if (closesTour)
+            {
+                route.places.push_back(0);
+                route.cost += roadCost;
+                recordCompleteRoute(route, threadBest);
+                instrumentation::count(instrumentation::RoutesCompleted);
+                route.places.pop_back();
+                route.cost -= roadCost;
+
+                // Nothing else can follow a closed tour from this place
+                frame.nextRoad = neighbourIndex.degree(frame.previousPlace);
+                continue;
+            }
+
+            int nextNumberOfPlacesVisited = currentPlace == 0 ? 0 : frame.numberOfPlacesVisited+1;
+            Load nextVehicleLoad = currentPlace == 0 ? 0 : frame.vehicleLoad+placesDemand[currentPlace];
+            Place nextTripStart = frame.numberOfPlacesVisited == 0 && currentPlace != 0 ? currentPlace : frame.tripStart;
+
+            route.places.push_back(currentPlace);
+            route.cost += roadCost;
+            if (currentPlace != 0)
+            {
+                placesVisited |= placeBit(currentPlace);
+                unvisitedLowerBound -= cheapestOutgoingRoad[currentPlace];
+            }
+
+            stack.push_back({currentPlace, nextNumberOfPlacesVisited, nextVehicleLoad, nextTripStart, 0, roadCost});
+            threadBest.nodesExpanded++;
+            instrumentation::count(instrumentation::NodesExpanded);
+            if (threadBest.nodesExpanded % nodesPerBudgetCheck == 0)
+                budget->spend(nodesPerBudgetCheck);
+        }
+    }
+
+    // Agree on the cheapest route across ranks and send it from its owner to everyone
+    void gatherBestRoute()
+    {
+        struct
+        {
+            int cost;
+            int rank;
+        } localBest = {bestRoute.cost, world_rank}, globalBest;
+        instrumentation::MpiWaitScope wait;
+        MPI_Allreduce(&localBest, &globalBest, 1, MPI_2INT, MPI_MINLOC, MPI_COMM_WORLD);
+
+        int routeSize = static_cast<int>(bestRoute.places.size());
+        MPI_Bcast(&routeSize, 1, MPI_INT, globalBest.rank, MPI_COMM_WORLD);
+        bestRoute.places.resize(routeSize);
+        MPI_Bcast(bestRoute.places.data(), routeSize, MPI_INT, globalBest.rank, MPI_COMM_WORLD);
+        bestRoute.cost = globalBest.cost;
+
+        long long localNodesExpanded = nodesExpanded;
+        MPI_Allreduce(&localNodesExpanded, &nodesExpanded, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+        int localStopped = budget->exhausted();
+        int anyStopped;
+        MPI_Allreduce(&localStopped, &anyStopped, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+        stoppedByBudget = anyStopped;
+    }
+};
+
+} // namespace mpi_global_search
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+#include <omp.h>
+#include <mpi.h>
+
+#include "problem.h"
+#include "budget.h"
+#include "elite_pool.h"
+#include "instrumentation.h"
+#include "random.h"
+#include "construction.h"
+#include "improvement.h"
+#include "neighbours.h"
+#include "solver.h"
+
+// Island model of the cooperative local search over MPI ranks. Needs an MPI compiler,
+// so only the MPI drivers include it.
+namespace mpi_local_search
+{
+
+class CapacitatedVehicleRoutingProblem : public Solver
+{
+    public:
+    Route bestRoute;
+    Cost lowerCost = INT_MAX;
+    int world_rank;
+    int world_size;
+
+    CapacitatedVehicleRoutingProblem(
+        const Problem& problem,
+        uint64_t seed,
+        int world_rank,
+        int world_size,
+        ConstructionMode constructionMode = ConstructionMode::RandomizedGreedy,
+        double graspAlpha = 0.3,
+        int iterations = 10000,
+        bool improveRoutes = false,
+        int maxNeighbours = 0,
+        int migrationInterval = 100,
+        int eliteSize = 8,
+        double eliteRestartProbability = 0.8,
+        int perturbationSwaps = 3
+    ) : world_rank(world_rank), world_size(world_size), numberOfPlaces(problem.numberOfPlaces), vehicleCapacity(problem.vehicleCapacity), maxNumberOfPlacesPerRoute(problem.maxNumberOfPlacesPerRoute), placesDemand(problem.placesDemand), roads(problem.roads), seed(seed), constructionMode(constructionMode), graspAlpha(graspAlpha), iterations(iterations), improveRoutes(improveRoutes), maxNeighbours(maxNeighbours), migrationInterval(migrationInterval), eliteSize(eliteSize), eliteRestartProbability(eliteRestartProbability), perturbationSwaps(perturbationSwaps) {}
+
+    // Runs until this rank's share of `iterations` is done or `budget` is exhausted. A unit
+    // of work is one construction. A rank out of budget still takes part in every epoch,
+    // so each rank sends and receives the same number of migrants.
+    void solve(SearchBudget& budget) override
+    {
+        neighbourIndex = NeighbourIndex(roads, maxNeighbours);
+        RouteConstruction construction(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute, constructionMode, graspAlpha, neighbourIndex);
+
+        int local_iterations = iterations / world_size;
+        int start = local_iterations * world_rank;
+        int end = (world_rank == world_size - 1) ? iterations : start + local_iterations;
+
+        // Every rank is an island with its own elite pool. After each epoch of
+        // migrationInterval iterations it sends its best route to the next rank on a ring and
+        // takes in whatever arrived from the previous one, without waiting for it.
+        ElitePool elitePool(omp_get_max_threads(), eliteSize);
+        Route localBestRoute;
+        Cost localLowerCost = INT_MAX;
+
+        int next = (world_rank + 1) % world_size;
+        int previous = (world_rank + world_size - 1) % world_size;
+        int numberOfEpochs = std::max(1, (local_iterations + migrationInterval - 1) / migrationInterval);
+        bool previousFinished = world_size == 1;
+        std::vector<int> sendBuffer(messageSize());
+        std::vector<int> receiveBuffer(messageSize());
+        MPI_Request sendRequest = MPI_REQUEST_NULL;
+        MPI_Request receiveRequest = MPI_REQUEST_NULL;
+        if (!previousFinished)
+            MPI_Irecv(receiveBuffer.data(), receiveBuffer.size(), MPI_INT, previous, 0, MPI_COMM_WORLD, &receiveRequest);
+
+        for (int epoch = 0; epoch < numberOfEpochs && !budget.exhausted(); ++epoch)
+        {
+            int epochStart = start + epoch * migrationInterval;
+            int epochEnd = (epoch == numberOfEpochs - 1) ? end : epochStart + migrationInterval;
+            searchEpoch(epochStart, epochEnd, construction, elitePool, budget, localBestRoute, localLowerCost);
+
+            if (world_size == 1)
+                continue;
+
+            // The previous migrant has had a whole epoch to leave, so this wait is short
+            {
+                instrumentation::MpiWaitScope wait;
+                MPI_Wait(&sendRequest, MPI_STATUS_IGNORE);
+            }
+            packRoute(localBestRoute, localLowerCost, sendBuffer);
+            MPI_Isend(sendBuffer.data(), sendBuffer[1] + 2, MPI_INT, next, 0, MPI_COMM_WORLD, &sendRequest);
+
+            int arrived = 1;
+            while (!previousFinished)
+            {
+                MPI_Test(&receiveRequest, &arrived, MPI_STATUS_IGNORE);
+                if (!arrived)
+                    break;
+                receiveMigrant(receiveBuffer, elitePool, previous, receiveRequest, previousFinished);
+            }
+        }
+
+        // Ranks may stop after different epochs when the budget runs out, so each one marks
+        // the end of its migrants and drains the previous rank up to its mark
+        instrumentation::MpiWaitScope wait;
+        if (world_size > 1)
+        {
+            MPI_Wait(&sendRequest, MPI_STATUS_IGNORE);
+            sendBuffer[1] = endOfMigration;
+            MPI_Isend(sendBuffer.data(), 2, MPI_INT, next, 0, MPI_COMM_WORLD, &sendRequest);
+
+            while (!previousFinished)
+            {
+                MPI_Wait(&receiveRequest, MPI_STATUS_IGNORE);
+                receiveMigrant(receiveBuffer, elitePool, previous, receiveRequest, previousFinished);
+            }
+            MPI_Wait(&sendRequest, MPI_STATUS_IGNORE);
+        }
+
+        // The cheapest rank is found with one reduction, ties going to the lowest rank,
+        // and broadcasts its route to everyone
+        struct { int cost; int rank; } local = {localLowerCost, world_rank}, global;
+        MPI_Allreduce(&local, &global, 1, MPI_2INT, MPI_MINLOC, MPI_COMM_WORLD);
+
+        if (world_rank == global.rank)
+            packRoute(localBestRoute, localLowerCost, sendBuffer);
+        MPI_Bcast(sendBuffer.data(), sendBuffer.size(), MPI_INT, global.rank, MPI_COMM_WORLD);
+
+        lowerCost = sendBuffer[0];
+        bestRoute.assign(sendBuffer.begin() + 2, sendBuffer.begin() + 2 + sendBuffer[1]);
+    }
+
+    Solution solution() const override
+    {
+        return Solution(bestRoute, lowerCost);
+    }
+
+    private:
+    int numberOfPlaces;
+    int vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    const std::vector<Load>& placesDemand;
+    const RoadMatrix& roads;
+    uint64_t seed;
+    ConstructionMode constructionMode;
+    double graspAlpha;
+    int iterations;
+    bool improveRoutes;
+    int maxNeighbours;
+    int migrationInterval;
+    int eliteSize;
+    double eliteRestartProbability;
+    int perturbationSwaps;
+    NeighbourIndex neighbourIndex;
+
+    // Runs iterations [epochStart, epochEnd) on this rank's threads. Each iteration either
+    // restarts from a perturbed elite of the island or builds a route from scratch.
+    void searchEpoch(int epochStart, int epochEnd, const RouteConstruction& construction,
+                     ElitePool& elitePool, SearchBudget& budget, Route& localBestRoute, Cost& localLowerCost)
+    {
+        #pragma omp parallel
+        {
+            instrumentation::RegionScope region;
+            Route threadBestRoute;
+            Cost threadLowerCost = INT_MAX;
+            RouteImprovement improvement(roads, placesDemand, vehicleCapacity, maxNumberOfPlacesPerRoute);
+            int shard = omp_get_thread_num();
+
+            #pragma omp for schedule(dynamic) nowait
+            for (int i = epochStart; i < epochEnd; ++i)
+            {
+                // A worksharing loop cannot break, so the iterations left are skipped
+                if (!budget.spend())
+                    continue;
+
+                instrumentation::BusyScope busy;
+                RandomGenerator random = RandomGenerator::forIteration(seed, i);
+                std::pair<Route, Cost> result = construction.iterate(random, &elitePool, shard,
+                    eliteRestartProbability, perturbationSwaps, improveRoutes ? &improvement : nullptr);
+                budget.improved(result.second);
+                if (result.second < threadLowerCost)
+                {
+                    threadBestRoute = result.first;
+                    threadLowerCost = result.second;
+                }
+            }
+
+            #pragma omp critical
+            {
+                if (threadLowerCost < localLowerCost)
+                {
+                    localBestRoute = threadBestRoute;
+                    localLowerCost = threadLowerCost;
+                }
+            }
+        }
+    }
+
+    // Length sent in place of a route after a rank's last migrant
+    static constexpr int endOfMigration = -1;
+
+    // A route travels as [cost, length, places...]. A route visits the depot at most once
+    // per customer, so 2 * numberOfPlaces places always fit.
+    int messageSize() const
+    {
+        return 2 + 2 * numberOfPlaces;
+    }
+
+    void packRoute(const Route& route, Cost cost, std::vector<int>& buffer) const
+    {
+        buffer[0] = cost;
+        buffer[1] = route.size();
+        std::copy(route.begin(), route.end(), buffer.begin() + 2);
+    }
+
+    // Takes in the message just received and posts the receive for the next one, unless
+    // the previous rank marked the end of its migrants
+    void receiveMigrant(std::vector<int>& buffer, ElitePool& elitePool, int previous, MPI_Request& receiveRequest, bool& previousFinished) const
+    {
+        if (buffer[1] == endOfMigration)
+        {
+            previousFinished = true;
+            return;
+        }
+
+        if (buffer[0] != INT_MAX)
+        {
+            Route migrant(buffer.begin() + 2, buffer.begin() + 2 + buffer[1]);
+            elitePool.publish(0, migrant, buffer[0]);
+        }
+
+        MPI_Irecv(buffer.data(), buffer.size(), MPI_INT, previous, 0, MPI_COMM_WORLD, &receiveRequest);
+    }
+};
+
+} // namespace mpi_local_search
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "problem.h"
+#include "best_routes.h"
+#include "solver.h"
+#include "budget.h"
+#include "instrumentation.h"
+#include "neighbours.h"
+
+namespace parallel_global_search
+{
+
+enum class SearchMode
+{
+    Exhaustive,     // Visit every feasible tour once, folding each one into the best routes
+    BranchAndBound  // Also cut partial routes that cannot beat the shared incumbent
+};
+
+// Per-thread results are padded to a cache line so threads never share one
+struct alignas(64) ThreadSearchResults
+{
+    BestRoutes routes;
+    long long nodesExpanded = 0;
+    long long tasksSpawned = 0;
+
+    explicit ThreadSearchResults(int capacity) : routes(capacity) {}
+};
+
+struct SearchStatistics
+{
+    long long nodesExpanded = 0;
+    long long tasksSpawned = 0;
+};
+
+class CapacitatedVehicleRoutingProblem : public Solver
+{
+    public:
+    Solution bestRoute;
+    std::vector<Solution> topRoutes;
+    SearchStatistics statistics;
+    bool stoppedByBudget = false;
+
+    CapacitatedVehicleRoutingProblem(
+        const Problem& problem,
+        SearchMode searchMode = SearchMode::Exhaustive,
+        int numberOfBestRoutes = 1,
+        int taskCutoffDepth = 3
+    ) : numberOfPlaces(problem.numberOfPlaces), vehicleCapacity(problem.vehicleCapacity), maxNumberOfPlacesPerRoute(problem.maxNumberOfPlacesPerRoute),
+        roads(problem.roads), placesDemand(problem.placesDemand), searchMode(searchMode), numberOfBestRoutes(numberOfBestRoutes),
+        taskCutoffDepth(taskCutoffDepth) {}
+
+    // Stops early, keeping the best routes found so far, once `budget` is exhausted.
+    // A unit of work is one node, and every thread charges the same budget.
+    void solve(SearchBudget& budget) override
+    {
+        this->budget = &budget;
+        neighbourIndex = NeighbourIndex(roads);
+        computeCheapestOutgoingRoads();
+
+        // Every route alternates customers and depot returns, so it never holds more
+        // than two entries per customer plus the starting depot.
+        SearchState state;
+        state.route = Solution({0}, 0);
+        state.route.places.reserve(2 * numberOfPlaces);
+        state.placesVisited = placeBit(0);
+        for (Place place = 1; place < numberOfPlaces; ++place)
+            state.unvisitedLowerBound += cheapestOutgoingRoad[place];
+
+        incumbentCost.store(INT_MAX, std::memory_order_relaxed);
+        threadResults.assign(omp_get_max_threads(), ThreadSearchResults(numberOfBestRoutes));
+
+        #pragma omp parallel
+        {
+            instrumentation::RegionScope region;
+            #pragma omp single
+            {
+                instrumentation::BusyScope busy;
+                generateAllRouteCombinationsWithRestrictions(state, 0, 0, 0, 0);
+            }
+        }
+
+        BestRoutes bestRoutes(numberOfBestRoutes);
+        statistics = SearchStatistics();
+        for (auto const& results : threadResults)
+        {
+            bestRoutes.merge(results.routes);
+            statistics.nodesExpanded += results.nodesExpanded;
+            statistics.tasksSpawned += results.tasksSpawned;
+        }
+
+        topRoutes = bestRoutes.sorted();
+        if (!topRoutes.empty())
+            bestRoute = topRoutes.front();
+        stoppedByBudget = budget.exhausted();
+    }
+
+    Solution solution() const override
+    {
+        return bestRoute;
+    }
+
+    std::string details() const override
+    {
+        std::string lines = "Nodes expanded: " + std::to_string(statistics.nodesExpanded)
+            + " (" + std::to_string(statistics.tasksSpawned) + " tasks)\n";
+        if (stoppedByBudget)
+            lines += "Stopped by the budget: best route found so far, not proven optimal\n";
+        return lines;
+    }
+
+    private:
+    // Mutable state of one depth-first walk. Each task owns a copy taken when it is
+    // spawned and below the cutoff depth it is updated in place with do/undo moves.
+    struct SearchState
+    {
+        Solution route = Solution({}, 0);
+        PlaceMask placesVisited = 0;
+        Cost unvisitedLowerBound = 0;
+    };
+
+    int numberOfPlaces;
+    int vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+    const RoadMatrix& roads;
+    NeighbourIndex neighbourIndex;
+    const std::vector<Load>& placesDemand;
+    SearchMode searchMode;
+    int numberOfBestRoutes;
+    int taskCutoffDepth;
+    std::vector<ThreadSearchResults> threadResults;
+    SearchBudget* budget = nullptr;
+
+    // Reading the clock costs more than a node, so nodes are charged in batches
+    static constexpr long long nodesPerBudgetCheck = 1024;
+
+    // Cheapest cost a route must beat to enter some thread's best routes, shared by
+    // every thread so a bound found anywhere prunes everywhere.
+    std::atomic<Cost> incumbentCost{INT_MAX};
+
+    // Cheapest road leaving each place, used as an admissible lower bound:
+    // every place not yet visited must still be left exactly once.
+    std::vector<Cost> cheapestOutgoingRoad;
+
+    void computeCheapestOutgoingRoads()
+    {
+        cheapestOutgoingRoad.assign(numberOfPlaces, 0);
+
+        for (Place place = 0; place < numberOfPlaces; ++place)
+        {
+            // The index is sorted, so the cheapest road comes first
+            Cost cheapest = neighbourIndex.degree(place) > 0 ? neighbourIndex.at(place, 0).cost : NO_ROAD;
+            cheapestOutgoingRoad[place] = cheapest == NO_ROAD ? 0 : cheapest;
+        }
+    }
+
+    void recordCompleteRoute(const Solution& route)
+    {
+        // No task scheduling point can occur in here, so the thread's results are
+        // only ever touched by the task running on that thread.
+        BestRoutes& routes = threadResults[omp_get_thread_num()].routes;
+        routes.offer(route);
+        instrumentation::count(instrumentation::RoutesCompleted);
+
+        Cost keptCost = routes.worstKeptCost();
+        Cost incumbent = incumbentCost.load(std::memory_order_relaxed);
+        while (keptCost < incumbent && !incumbentCost.compare_exchange_weak(incumbent, keptCost, std::memory_order_relaxed));
+        budget->improved(route.cost);
+    }
+
+    void visitPlace(SearchState& state, Place place, Cost roadCost)
+    {
+        state.route.cost += roadCost;
+        state.route.places.push_back(place);
+        state.placesVisited |= placeBit(place);
+        if (place != 0)
+            state.unvisitedLowerBound -= cheapestOutgoingRoad[place];
+    }
+
+    void undoVisitPlace(SearchState& state, Place place, Cost roadCost)
+    {
+        // The depot stays visited: it was already in the set before the move
+        if (place != 0)
+        {
+            state.placesVisited &= ~placeBit(place);
+            state.unvisitedLowerBound += cheapestOutgoingRoad[place];
+        }
+        state.route.places.pop_back();
+        state.route.cost -= roadCost;
+    }
+
+    // `tripStart` is the first customer of the current trip, or of the last one when the
+    // vehicle is at the depot. Reordering the trips of a tour leaves its cost unchanged, so
+    // each tour is only generated once, with its trips ordered by their first customer.
+    void generateAllRouteCombinationsWithRestrictions(
+        SearchState& state,
+        int numberOfPlacesVisited,
+        Place previousPlace,
+        Load vehicleLoad,
+        Place tripStart
+    )
+    {
+        ThreadSearchResults& results = threadResults[omp_get_thread_num()];
+        results.nodesExpanded++;
+        instrumentation::count(instrumentation::NodesExpanded);
+        if (results.nodesExpanded % nodesPerBudgetCheck == 0)
+            budget->spend(nodesPerBudgetCheck);
+        if (budget->exhausted())
+            return;
+
+        // Near the root every child becomes a task that idle threads can pick up;
+        // deeper subtrees are too small to pay for one and run in place.
+        int depth = static_cast<int>(state.route.places.size()) - 1;
+        bool spawnTasks = depth < taskCutoffDepth;
+
+        const PlaceMask everyPlace = allPlacesMask(numberOfPlaces);
+
+        // Only existing roads, cheapest first, so good tours are found early
+        for (const Neighbour& road : neighbourIndex.of(previousPlace))
+        {
+            Place currentPlace = road.place;
+            Cost roadCost = road.cost;
+
+            // Filter places already visited
+            if ((state.placesVisited & placeBit(currentPlace)) && currentPlace != 0)
+                continue;
+
+            // A new trip must start after the previous one
+            if (numberOfPlacesVisited == 0 && currentPlace <= tripStart)
+                continue;
+
+            if (currentPlace != 0)
+            {
+                bool loadExceeded = (vehicleLoad+placesDemand[currentPlace]) > vehicleCapacity;
+                bool placesExceeded = (numberOfPlacesVisited+1) > maxNumberOfPlacesPerRoute;
+                if (loadExceeded || placesExceeded)
+                    continue;
+            }
+
+            bool closesTour = currentPlace == 0 && state.placesVisited == everyPlace;
+
+            if (searchMode == SearchMode::BranchAndBound)
+            {
+                // Unless this move closes the tour, the current place must still be left once more
+                Cost remainingLowerBound = state.unvisitedLowerBound;
+                if (currentPlace != 0)
+                    remainingLowerBound -= cheapestOutgoingRoad[currentPlace];
+                if (!closesTour)
+                    remainingLowerBound += cheapestOutgoingRoad[currentPlace];
+
+                if (state.route.cost + roadCost + remainingLowerBound >= incumbentCost.load(std::memory_order_relaxed))
+                {
+                    instrumentation::count(instrumentation::NodesPruned);
+                    continue;
+                }
+            }
+
+            visitPlace(state, currentPlace, roadCost);
+
+            if (closesTour)
+            {
+                recordCompleteRoute(state.route);
+                undoVisitPlace(state, currentPlace, roadCost);
+                return;
+            }
+
+            int nextNumberOfPlacesVisited = currentPlace == 0 ? 0 : numberOfPlacesVisited+1;
+            Load nextVehicleLoad = currentPlace == 0 ? 0 : vehicleLoad+placesDemand[currentPlace];
+            Place nextTripStart = numberOfPlacesVisited == 0 && currentPlace != 0 ? currentPlace : tripStart;
+
+            if (spawnTasks)
+            {
+                results.tasksSpawned++;
+                instrumentation::count(instrumentation::TasksSpawned);
+                #pragma omp task firstprivate(state, nextNumberOfPlacesVisited, currentPlace, nextVehicleLoad, nextTripStart)
+                {
+                    instrumentation::BusyScope busy;
+                    generateAllRouteCombinationsWithRestrictions(state, nextNumberOfPlacesVisited, currentPlace, nextVehicleLoad, nextTripStart);
+                }
+            } else {
+                generateAllRouteCombinationsWithRestrictions(state, nextNumberOfPlacesVisited, currentPlace, nextVehicleLoad, nextTripStart);
+            }
+
+            undoVisitPlace(state, currentPlace, roadCost);
+        }
+    }
+};
+
+} // namespace parallel_global_search
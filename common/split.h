@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "problem.h"
+
+// Optimal split of a giant tour (Prins). A giant tour is an order of all the customers
+// without any depot returns; the split chooses where the vehicle goes back to the depot.
+// best[j] is the cheapest way to serve the first j customers of the tour, and each trip
+// tour[i..j] is extended one customer at a time, so a split costs O(n * maxStops). The
+// resulting trips are the cheapest possible for that order of customers.
+class GiantTourSplit
+{
+    public:
+    GiantTourSplit(
+        const RoadMatrix& roads,
+        const std::vector<Load>& placesDemand,
+        Load vehicleCapacity,
+        int maxNumberOfPlacesPerRoute
+    ) : roads(roads), placesDemand(placesDemand), vehicleCapacity(vehicleCapacity),
+        maxNumberOfPlacesPerRoute(maxNumberOfPlacesPerRoute) {}
+
+    // Writes the best route for `giantTour` into `route` and returns its cost, or NO_ROAD
+    // when no split respects the roads and the vehicle limits.
+    Cost split(const std::vector<Place>& giantTour, std::vector<Place>& route) const
+    {
+        int numberOfCustomers = giantTour.size();
+        std::vector<Cost> best(numberOfCustomers + 1, NO_ROAD);
+        std::vector<int> tripStart(numberOfCustomers + 1, 0);
+        best[0] = 0;
+
+        for (int first = 0; first < numberOfCustomers; ++first)
+        {
+            if (best[first] == NO_ROAD || !roads.hasRoad(0, giantTour[first]))
+                continue;
+
+            Load load = 0;
+            Cost pathCost = roads.cost(0, giantTour[first]);
+            for (int last = first; last < numberOfCustomers && last - first < maxNumberOfPlacesPerRoute; ++last)
+            {
+                if (last > first)
+                {
+                    // A missing road inside the trip also rules out every longer trip
+                    if (!roads.hasRoad(giantTour[last - 1], giantTour[last]))
+                        break;
+                    pathCost += roads.cost(giantTour[last - 1], giantTour[last]);
+                }
+
+                load += placesDemand[giantTour[last]];
+                if (load > vehicleCapacity)
+                    break;
+
+                if (!roads.hasRoad(giantTour[last], 0))
+                    continue;
+
+                Cost cost = best[first] + pathCost + roads.cost(giantTour[last], 0);
+                if (cost < best[last + 1])
+                {
+                    best[last + 1] = cost;
+                    tripStart[last + 1] = first;
+                }
+            }
+        }
+
+        route.clear();
+        if (best[numberOfCustomers] == NO_ROAD)
+            return NO_ROAD;
+
+        // Walk the trips back from the end of the tour, then put them in order
+        route.push_back(0);
+        for (int end = numberOfCustomers; end > 0; end = tripStart[end])
+        {
+            for (int position = end - 1; position >= tripStart[end]; --position)
+                route.push_back(giantTour[position]);
+            route.push_back(0);
+        }
+        std::reverse(route.begin(), route.end());
+
+        return best[numberOfCustomers];
+    }
+
+    // Customers of a route in visiting order, with the depot returns removed
+    static std::vector<Place> giantTourOf(const std::vector<Place>& route)
+    {
+        std::vector<Place> giantTour;
+        for (Place place : route)
+        {
+            if (place != 0)
+                giantTour.push_back(place);
+        }
+        return giantTour;
+    }
+
+    private:
+    const RoadMatrix& roads;
+    const std::vector<Load>& placesDemand;
+    Load vehicleCapacity;
+    int maxNumberOfPlacesPerRoute;
+};
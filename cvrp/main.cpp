@@ -0,0 +1,320 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <omp.h>
+
+#include "driver.h"
+#include "batch.h"
+#include "solvers/global_search.h"
+#include "solvers/parallel_global_search.h"
+#include "solvers/dynamic_programming_search.h"
+#include "solvers/local_search.h"
+#include "solvers/cooperative_local_search.h"
+#include "solvers/genetic_search.h"
+#include "solvers/alns_search.h"
+
+// Everything the command line sets. An iteration count of 0 keeps the algorithm's own.
+struct Options
+{
+    std::string algorithm = "local";
+    std::vector<std::string> fileNames;
+    std::vector<std::string> batchSources; // Directories or manifests; any of them selects batch mode
+    int largeInstanceCustomers = 50;
+    Load vehicleCapacity = 20;
+    int maxNumberOfPlacesPerRoute = 3;
+    int threads = 0; // As many as OpenMP chooses
+    uint64_t seed = 42;
+    int iterations = 0;
+    double timeLimitSeconds = 0; // No time limit
+    long long workLimit = 0; // No work limit
+    bool reportProgress = false;
+};
+
+using Factory = std::unique_ptr<Solver> (*)(const Problem& problem, const Options& options);
+
+static int iterationsOr(const Options& options, int defaultIterations)
+{
+    return options.iterations > 0 ? options.iterations : defaultIterations;
+}
+
+static std::unique_ptr<Solver> createGlobal(const Problem& problem, const Options& options)
+{
+    using namespace global_search;
+
+    if (problem.numberOfPlaces > MAX_PLACES_IN_MASK)
+    {
+        std::cerr << "Too many places for the global search" << std::endl;
+        return nullptr;
+    }
+    return std::make_unique<CapacitatedVehicleRoutingProblem>(problem, SearchMode::BranchAndBound);
+}
+
+static std::unique_ptr<Solver> createParallelGlobal(const Problem& problem, const Options& options)
+{
+    using namespace parallel_global_search;
+
+    if (problem.numberOfPlaces > MAX_PLACES_IN_MASK)
+    {
+        std::cerr << "Too many places for the global search" << std::endl;
+        return nullptr;
+    }
+    return std::make_unique<CapacitatedVehicleRoutingProblem>(problem, SearchMode::BranchAndBound);
+}
+
+static std::unique_ptr<Solver> createDynamicProgramming(const Problem& problem, const Options& options)
+{
+    using namespace dynamic_programming_search;
+
+    if (problem.numberOfPlaces - 1 > MAX_DP_CUSTOMERS)
+    {
+        std::cerr << "Too many customers for the dynamic programming search" << std::endl;
+        return nullptr;
+    }
+    return std::make_unique<CapacitatedVehicleRoutingProblem>(problem);
+}
+
+static std::unique_ptr<Solver> createLocal(const Problem& problem, const Options& options)
+{
+    using namespace local_search;
+
+    return std::make_unique<CapacitatedVehicleRoutingProblem>(
+        problem,
+        options.seed,
+        ConstructionMode::GiantTourSplit,
+        1.0, // graspAlpha
+        iterationsOr(options, 10),
+        true, // improveRoutes
+        0, // Keep every road
+        ImprovementMode::SimulatedAnnealing,
+        100000 // improvementSteps
+    );
+}
+
+static std::unique_ptr<Solver> createParallelLocal(const Problem& problem, const Options& options)
+{
+    using namespace cooperative_local_search;
+
+    return std::make_unique<CapacitatedVehicleRoutingProblem>(
+        problem,
+        options.seed,
+        ConstructionMode::GiantTourSplit,
+        1.0, // graspAlpha
+        iterationsOr(options, 1000),
+        true, // improveRoutes
+        0, // Keep every road
+        true // cooperative
+    );
+}
+
+static std::unique_ptr<Solver> createGenetic(const Problem& problem, const Options& options)
+{
+    using namespace genetic_search;
+
+    return std::make_unique<CapacitatedVehicleRoutingProblem>(
+        problem,
+        options.seed,
+        25, // populationSize
+        40, // generationSize
+        32, // childrenPerGeneration
+        iterationsOr(options, 500)
+    );
+}
+
+static std::unique_ptr<Solver> createAlns(const Problem& problem, const Options& options)
+{
+    using namespace alns_search;
+
+    return std::make_unique<CapacitatedVehicleRoutingProblem>(problem, options.seed, iterationsOr(options, 20000));
+}
+
+struct Algorithm
+{
+    const char* name;
+    Factory create;
+    bool threaded; // Parallelises within one instance
+    const char* description;
+};
+
+static const Algorithm algorithms[] = {
+    {"global", createGlobal, false, "branch and bound, exact (up to 63 customers)"},
+    {"parallel-global", createParallelGlobal, true, "branch and bound on OpenMP tasks, exact (up to 63 customers)"},
+    {"dp", createDynamicProgramming, true, "dynamic programming over subsets, exact (up to 24 customers)"},
+    {"local", createLocal, false, "giant tour construction with simulated annealing; iterations are constructions"},
+    {"parallel-local", createParallelLocal, true, "cooperative OpenMP multi-start; iterations are constructions"},
+    {"genetic", createGenetic, false, "genetic algorithm; iterations are generations"},
+    {"alns", createAlns, false, "adaptive large neighbourhood search; iterations are destroy and repair steps"},
+};
+
+static void printUsage(std::ostream& out)
+{
+    out << "Usage: cvrp [options] instance...\n"
+        << "  --algorithm NAME    solver to run (default local)\n"
+        << "  --capacity N        vehicle capacity, 1 to " << MAX_VEHICLE_CAPACITY << " (default 20)\n"
+        << "  --max-stops N       most customers on one trip (default 3)\n"
+        << "  --threads N         OpenMP threads (default: OpenMP's choice)\n"
+        << "  --seed N            random seed of the heuristics (default 42)\n"
+        << "  --iterations N      iterations of the heuristics (default: the algorithm's own)\n"
+        << "  --time-limit S      stop after S seconds per instance, keeping the best route so far\n"
+        << "  --work-limit N      stop after N units of work (nodes, subsets or iterations)\n"
+        << "  --progress          write every new best cost to stderr\n"
+        << "  --batch SOURCE      solve many instances concurrently, one per thread, printing each result\n"
+        << "                      as it completes; SOURCE is a directory of .txt instances or a manifest\n"
+        << "                      with one instance per line, and may be repeated\n"
+        << "  --large-customers N in batch mode, solve instances with more than N customers one at a time\n"
+        << "                      with every thread, when the algorithm is threaded (default 50)\n"
+        << "Algorithms:\n";
+    for (const Algorithm& algorithm : algorithms)
+        out << "  " << algorithm.name << ": " << algorithm.description << "\n";
+}
+
+template <typename Value>
+static bool parseValue(const std::string& text, Value& value)
+{
+    std::istringstream iss(text);
+    iss >> value;
+    return !iss.fail() && iss.eof();
+}
+
+// Returns false, after printing why, on an unknown option or a malformed value
+static bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument.rfind("--", 0) != 0)
+        {
+            options.fileNames.push_back(argument);
+            continue;
+        }
+        if (argument == "--progress")
+        {
+            options.reportProgress = true;
+            continue;
+        }
+
+        if (i + 1 == argc)
+        {
+            std::cerr << "Missing value for " << argument << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        bool parsed;
+        if (argument == "--algorithm")
+        {
+            options.algorithm = value;
+            parsed = true;
+        }
+        else if (argument == "--capacity")
+            parsed = parseValue(value, options.vehicleCapacity) && options.vehicleCapacity > 0 &&
+                     options.vehicleCapacity <= MAX_VEHICLE_CAPACITY;
+        else if (argument == "--max-stops")
+            parsed = parseValue(value, options.maxNumberOfPlacesPerRoute) && options.maxNumberOfPlacesPerRoute > 0;
+        else if (argument == "--threads")
+            parsed = parseValue(value, options.threads) && options.threads > 0;
+        else if (argument == "--seed")
+            parsed = parseValue(value, options.seed);
+        else if (argument == "--iterations")
+            parsed = parseValue(value, options.iterations) && options.iterations > 0;
+        else if (argument == "--time-limit")
+            parsed = parseValue(value, options.timeLimitSeconds) && options.timeLimitSeconds >= 0;
+        else if (argument == "--work-limit")
+            parsed = parseValue(value, options.workLimit) && options.workLimit >= 0;
+        else if (argument == "--batch")
+        {
+            options.batchSources.push_back(value);
+            parsed = true;
+        }
+        else if (argument == "--large-customers")
+            parsed = parseValue(value, options.largeInstanceCustomers) && options.largeInstanceCustomers > 0;
+        else
+        {
+            std::cerr << "Unknown option: " << argument << std::endl;
+            return false;
+        }
+
+        if (!parsed)
+        {
+            std::cerr << "Invalid value for " << argument << ": " << value << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--help")
+        {
+            printUsage(std::cout);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(std::cerr);
+        return EXIT_FAILURE;
+    }
+    bool batch = !options.batchSources.empty();
+    for (const std::string& source : options.batchSources)
+    {
+        std::string error;
+        if (!listBatchInstances(source, options.fileNames, error))
+        {
+            std::cerr << error << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (batch && options.reportProgress)
+    {
+        // Progress lines do not name their instance, so concurrent ones could not be told apart
+        std::cerr << "--progress cannot be combined with --batch" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (options.fileNames.empty())
+    {
+        std::cerr << "No instance given" << std::endl;
+        printUsage(std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    const Algorithm* algorithm = nullptr;
+    for (const Algorithm& candidate : algorithms)
+        if (options.algorithm == candidate.name)
+            algorithm = &candidate;
+    if (algorithm == nullptr)
+    {
+        std::cerr << "Unknown algorithm: " << options.algorithm << std::endl;
+        printUsage(std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    if (options.threads > 0)
+        omp_set_num_threads(options.threads);
+
+    RunSettings settings;
+    settings.vehicleCapacity = options.vehicleCapacity;
+    settings.maxNumberOfPlacesPerRoute = options.maxNumberOfPlacesPerRoute;
+    settings.timeLimitSeconds = options.timeLimitSeconds;
+    settings.workLimit = options.workLimit;
+    settings.reportProgress = options.reportProgress;
+    settings.extraLines = std::string("Algorithm: ") + algorithm->name + "\n";
+
+    SolverFactory createSolver = [&](const Problem& problem) {
+        return algorithm->create(problem, options);
+    };
+    int failures = batch
+        ? solveBatch(options.fileNames, settings, createSolver, algorithm->threaded ? options.largeInstanceCustomers : 0)
+        : solveInstances(options.fileNames, settings, createSolver);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,29 @@
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include "driver.h"
+#include "solvers/dynamic_programming_search.h"
+
+using namespace dynamic_programming_search;
+
+int main()
+{
+    RunSettings settings;
+    settings.vehicleCapacity = 20;
+    settings.maxNumberOfPlacesPerRoute = 3;
+    settings.timeLimitSeconds = 0; // No time limit
+    settings.workLimit = 0; // No limit on the subsets evaluated
+    settings.reportProgress = false;
+
+    int failures = solveInstances(benchmarkInstances, settings, [&](const Problem& problem) -> std::unique_ptr<Solver> {
+        if (problem.numberOfPlaces - 1 > MAX_DP_CUSTOMERS)
+        {
+            std::cerr << "Too many places for the dynamic programming search" << std::endl;
+            return nullptr;
+        }
+        return std::make_unique<CapacitatedVehicleRoutingProblem>(problem);
+    });
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,38 @@
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+#include "driver.h"
+#include "solvers/genetic_search.h"
+
+using namespace genetic_search;
+
+int main()
+{
+    RunSettings settings;
+    settings.vehicleCapacity = 20;
+    settings.maxNumberOfPlacesPerRoute = 3;
+    settings.timeLimitSeconds = 0; // No time limit
+    settings.reportProgress = false;
+
+    uint64_t seed = 42;
+    int populationSize = 25;
+    int generationSize = 40;
+    int childrenPerGeneration = 32;
+    int maxGenerations = 500;
+    int maxGenerationsWithoutImprovement = 100;
+
+    int failures = solveInstances(benchmarkInstances, settings, [&](const Problem& problem) -> std::unique_ptr<Solver> {
+        return std::make_unique<CapacitatedVehicleRoutingProblem>(
+            problem,
+            seed,
+            populationSize,
+            generationSize,
+            childrenPerGeneration,
+            maxGenerations,
+            maxGenerationsWithoutImprovement
+        );
+    });
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,46 @@
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mpi.h>
+
+#include "driver.h"
+#include "solvers/mpi_global_search.h"
+
+using namespace mpi_global_search;
+
+int main(int argc, char *argv[])
+{
+    // Only the main thread talks to MPI, between the OpenMP parallel regions
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+    int world_size, world_rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+
+    if (world_rank == 0)
+        std::cout << "Running solution with " << world_size << " processes" << std::endl;
+
+    RunSettings settings;
+    settings.vehicleCapacity = 20;
+    settings.maxNumberOfPlacesPerRoute = 3;
+    settings.timeLimitSeconds = 0; // No time limit
+    settings.workLimit = 0; // No node limit, per rank
+    settings.reportProgress = false; // Only rank 0 reports; it learns the incumbents of the other ranks after each round
+    settings.rank = world_rank;
+
+    // Every rank reads the same instance, so they all skip the same ones
+    int failures = solveInstances(benchmarkInstances, settings, [&](const Problem& problem) -> std::unique_ptr<Solver> {
+        if (problem.numberOfPlaces > MAX_PLACES_IN_MASK)
+        {
+            if (world_rank == 0)
+                std::cerr << "Too many places for the global search" << std::endl;
+            return nullptr;
+        }
+        return std::make_unique<CapacitatedVehicleRoutingProblem>(problem, world_rank, world_size);
+    });
+
+    MPI_Finalize();
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,450 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "problem.h"
+#include "instance.h"
+#include "random.h"
+
+// Writes a random instance in the graphs/*.txt format, like the generator of
+// supercomp_project.ipynb: every customer has a road to and from the depot with the same
+// cost, and a road from customer i to each customer j > i exists with the edge
+// probability. With --two-way the road from j back to i is written as well.
+//
+// The costs are uniform random numbers (random), or rounded distances between points
+// spread uniformly over a square (uniform) or gathered around cluster centres (clustered).
+// Each row of roads draws from its own generator, seeded from the seed and the row, so the
+// same options give the same file for any number of threads.
+
+enum class Geometry
+{
+    Random,
+    Uniform,
+    Clustered
+};
+
+enum class DemandDistribution
+{
+    Uniform,
+    Constant,
+    Skewed
+};
+
+struct Options
+{
+    int customers = 10;
+    double edgeProbability = 0.5;
+    Geometry geometry = Geometry::Random;
+    int clusters = 8;
+    Cost maxCost = 100;
+    DemandDistribution demandDistribution = DemandDistribution::Uniform;
+    Load minDemand = 1;
+    Load maxDemand = 10;
+    bool twoWay = false;
+    uint64_t seed = 1;
+    std::string output = "-"; // Standard output
+};
+
+struct Point
+{
+    double x, y;
+};
+
+class InstanceGenerator
+{
+    public:
+    explicit InstanceGenerator(const Options& options) : options(options)
+    {
+        placePoints();
+        drawDemands();
+        drawDepotCosts();
+    }
+
+    // Number of roads, counted with the same draws writeRoads() makes
+    long long countRoads() const
+    {
+        long long roads = 0;
+
+        #pragma omp parallel for schedule(dynamic, 16) reduction(+:roads)
+        for (Place source = 0; source <= options.customers; ++source)
+            forEachRoadOfRow(source, [&](Place, Place, Cost) { ++roads; });
+
+        return roads;
+    }
+
+    bool write(std::FILE* file) const
+    {
+        OutputBuffer out(file);
+        out.number(options.customers).newLine();
+        for (Place place = 1; place <= options.customers; ++place)
+            out.number(place).space().number(demands[place]).newLine();
+        out.number(countRoads()).newLine();
+        out.flush();
+
+        // Rows are formatted in parallel, a few per thread at a time, and written in order
+        int rowsPerChunk = 4 * omp_get_max_threads();
+        std::vector<std::string> rowTexts(rowsPerChunk);
+        for (Place firstRow = 0; firstRow <= options.customers; firstRow += rowsPerChunk)
+        {
+            int rows = std::min(rowsPerChunk, options.customers + 1 - firstRow);
+
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int k = 0; k < rows; ++k)
+            {
+                std::string& text = rowTexts[k];
+                text.clear();
+                forEachRoadOfRow(firstRow + k, [&](Place source, Place destination, Cost cost) {
+                    appendNumber(text, source);
+                    text += ' ';
+                    appendNumber(text, destination);
+                    text += ' ';
+                    appendNumber(text, cost);
+                    text += '\n';
+                });
+            }
+
+            for (int k = 0; k < rows; ++k)
+                if (std::fwrite(rowTexts[k].data(), 1, rowTexts[k].size(), file) != rowTexts[k].size())
+                    return false;
+        }
+
+        return std::fflush(file) == 0;
+    }
+
+    private:
+    // Buffered writer for the short header lines
+    class OutputBuffer
+    {
+        public:
+        explicit OutputBuffer(std::FILE* file) : file(file) {}
+
+        OutputBuffer& number(long long value)
+        {
+            appendNumber(text, value);
+            return *this;
+        }
+
+        OutputBuffer& space()
+        {
+            text += ' ';
+            return *this;
+        }
+
+        OutputBuffer& newLine()
+        {
+            text += '\n';
+            if (text.size() >= 1 << 16)
+                flush();
+            return *this;
+        }
+
+        void flush()
+        {
+            std::fwrite(text.data(), 1, text.size(), file);
+            text.clear();
+        }
+
+        private:
+        std::FILE* file;
+        std::string text;
+    };
+
+    static void appendNumber(std::string& text, long long value)
+    {
+        char digits[24];
+        char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        text.append(digits, end);
+    }
+
+    // Seeds of the independent streams, so changing one draw does not shift the others
+    static constexpr uint64_t POINT_STREAM = 1;
+    static constexpr uint64_t DEMAND_STREAM = 2;
+    static constexpr uint64_t DEPOT_STREAM = 3;
+    static constexpr uint64_t ROW_STREAM = 4;
+
+    uint64_t streamSeed(uint64_t stream) const
+    {
+        return options.seed * 0xD1B54A32D192ED03ULL + stream;
+    }
+
+    // Side of the square, so that its diagonal is the largest cost
+    double side() const
+    {
+        return options.maxCost / std::sqrt(2.0);
+    }
+
+    void placePoints()
+    {
+        if (options.geometry == Geometry::Random)
+            return;
+
+        RandomGenerator random(streamSeed(POINT_STREAM));
+        points.resize(options.customers + 1);
+        points[0] = {side() / 2, side() / 2}; // The depot sits in the middle
+
+        std::vector<Point> centres;
+        for (int k = 0; k < options.clusters; ++k)
+            centres.push_back({random.nextDouble() * side(), random.nextDouble() * side()});
+
+        double spread = side() * 0.05;
+        for (Place place = 1; place <= options.customers; ++place)
+        {
+            if (options.geometry == Geometry::Uniform)
+            {
+                points[place] = {random.nextDouble() * side(), random.nextDouble() * side()};
+                continue;
+            }
+
+            // Box-Muller: two uniforms give a normally distributed offset from the centre
+            const Point& centre = centres[random.nextBelow(options.clusters)];
+            double radius = spread * std::sqrt(-2 * std::log(1 - random.nextDouble()));
+            double angle = 2 * M_PI * random.nextDouble();
+            points[place] = {std::clamp(centre.x + radius * std::cos(angle), 0.0, side()),
+                             std::clamp(centre.y + radius * std::sin(angle), 0.0, side())};
+        }
+    }
+
+    void drawDemands()
+    {
+        RandomGenerator random(streamSeed(DEMAND_STREAM));
+        Load range = options.maxDemand - options.minDemand;
+        demands.assign(options.customers + 1, 0);
+
+        for (Place place = 1; place <= options.customers; ++place)
+        {
+            switch (options.demandDistribution)
+            {
+                case DemandDistribution::Uniform:
+                    demands[place] = options.minDemand + random.nextBelow(range + 1);
+                    break;
+                case DemandDistribution::Constant:
+                    demands[place] = options.maxDemand;
+                    break;
+                case DemandDistribution::Skewed:
+                    // Exponential with a mean of a quarter of the range: mostly small
+                    // demands and a few close to the largest
+                    double draw = -std::log(1 - random.nextDouble()) * range / 4;
+                    demands[place] = options.minDemand + static_cast<Load>(std::min<double>(draw, range));
+                    break;
+            }
+        }
+    }
+
+    void drawDepotCosts()
+    {
+        RandomGenerator random(streamSeed(DEPOT_STREAM));
+        depotCosts.assign(options.customers + 1, 0);
+        for (Place place = 1; place <= options.customers; ++place)
+            depotCosts[place] = options.geometry == Geometry::Random ? randomCost(random) : distance(0, place);
+    }
+
+    Cost randomCost(RandomGenerator& random) const
+    {
+        return 1 + random.nextBelow(options.maxCost);
+    }
+
+    Cost distance(Place first, Place second) const
+    {
+        double dx = points[first].x - points[second].x;
+        double dy = points[first].y - points[second].y;
+        return std::max<Cost>(1, std::lround(std::sqrt(dx * dx + dy * dy)));
+    }
+
+    // Calls visitor(source, destination, cost) for the roads written in row `row`: the
+    // depot's roads for row 0; for a customer, its road to the depot and its roads to the
+    // customers after it. Present roads are found by geometric skips, so a sparse row
+    // costs time in proportion to its roads rather than to the customers.
+    template <typename Visitor>
+    void forEachRoadOfRow(Place row, Visitor&& visitor) const
+    {
+        if (row == 0)
+        {
+            for (Place place = 1; place <= options.customers; ++place)
+                visitor(0, place, depotCosts[place]);
+            return;
+        }
+
+        visitor(row, 0, depotCosts[row]);
+        if (options.edgeProbability <= 0)
+            return;
+
+        RandomGenerator random = RandomGenerator::forIteration(streamSeed(ROW_STREAM), row);
+        double logMiss = std::log1p(-options.edgeProbability);
+        Place destination = row;
+        while (true)
+        {
+            if (options.edgeProbability >= 1)
+                ++destination;
+            else
+            {
+                double skip = std::floor(std::log(1 - random.nextDouble()) / logMiss);
+                if (skip >= options.customers - destination)
+                    break;
+                destination += 1 + static_cast<Place>(skip);
+            }
+            if (destination > options.customers)
+                break;
+
+            Cost cost = options.geometry == Geometry::Random ? randomCost(random) : distance(row, destination);
+            visitor(row, destination, cost);
+            if (options.twoWay)
+                visitor(destination, row, cost);
+        }
+    }
+
+    const Options& options;
+    std::vector<Point> points;
+    std::vector<Load> demands;
+    std::vector<Cost> depotCosts;
+};
+
+static void printUsage(std::ostream& out)
+{
+    out << "Usage: generate [options]\n"
+        << "  --customers N            customers besides the depot, 1 to " << MAX_INSTANCE_CUSTOMERS
+        << ", the most the solvers load (default 10)\n"
+        << "  --edge-probability P     chance of a road between two customers (default 0.5)\n"
+        << "  --two-way                also write the road back between customers\n"
+        << "  --geometry NAME          random, uniform or clustered (default random)\n"
+        << "  --clusters N             cluster centres of the clustered geometry (default 8)\n"
+        << "  --max-cost N             largest road cost (default 100)\n"
+        << "  --demand NAME            uniform, constant or skewed (default uniform)\n"
+        << "  --min-demand N           smallest demand (default 1)\n"
+        << "  --max-demand N           largest demand, and the constant one (default 10)\n"
+        << "  --seed N                 random seed (default 1)\n"
+        << "  --output FILE            file to write, - for standard output (default -)\n";
+}
+
+template <typename Value>
+static bool parseValue(const std::string& text, Value& value)
+{
+    std::istringstream iss(text);
+    iss >> value;
+    return !iss.fail() && iss.eof();
+}
+
+// Returns false, after printing why, on an unknown option or a value out of range
+static bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--two-way")
+        {
+            options.twoWay = true;
+            continue;
+        }
+
+        if (i + 1 == argc)
+        {
+            std::cerr << "Missing value for " << argument << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        bool parsed = true;
+        if (argument == "--customers")
+            parsed = parseValue(value, options.customers) && options.customers >= 1 && options.customers <= MAX_INSTANCE_CUSTOMERS;
+        else if (argument == "--edge-probability")
+            parsed = parseValue(value, options.edgeProbability) && options.edgeProbability >= 0 && options.edgeProbability <= 1;
+        else if (argument == "--geometry")
+        {
+            if (value == "random")
+                options.geometry = Geometry::Random;
+            else if (value == "uniform")
+                options.geometry = Geometry::Uniform;
+            else if (value == "clustered")
+                options.geometry = Geometry::Clustered;
+            else
+                parsed = false;
+        }
+        else if (argument == "--clusters")
+            parsed = parseValue(value, options.clusters) && options.clusters >= 1;
+        else if (argument == "--max-cost")
+            parsed = parseValue(value, options.maxCost) && options.maxCost >= 1;
+        else if (argument == "--demand")
+        {
+            if (value == "uniform")
+                options.demandDistribution = DemandDistribution::Uniform;
+            else if (value == "constant")
+                options.demandDistribution = DemandDistribution::Constant;
+            else if (value == "skewed")
+                options.demandDistribution = DemandDistribution::Skewed;
+            else
+                parsed = false;
+        }
+        else if (argument == "--min-demand")
+            parsed = parseValue(value, options.minDemand) && options.minDemand >= 0;
+        else if (argument == "--max-demand")
+            parsed = parseValue(value, options.maxDemand) && options.maxDemand >= 0;
+        else if (argument == "--seed")
+            parsed = parseValue(value, options.seed);
+        else if (argument == "--output")
+            options.output = value;
+        else
+        {
+            std::cerr << "Unknown option: " << argument << std::endl;
+            return false;
+        }
+
+        if (!parsed)
+        {
+            std::cerr << "Invalid value for " << argument << ": " << value << std::endl;
+            return false;
+        }
+    }
+
+    if (options.minDemand > options.maxDemand)
+    {
+        std::cerr << "--min-demand is larger than --max-demand" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--help")
+        {
+            printUsage(std::cout);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    std::FILE* file = options.output == "-" ? stdout : std::fopen(options.output.c_str(), "w");
+    if (file == nullptr)
+    {
+        std::cerr << "Error opening file: " << options.output << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    InstanceGenerator generator(options);
+    bool written = generator.write(file);
+    if (file != stdout)
+        written = std::fclose(file) == 0 && written;
+    if (!written)
+    {
+        std::cerr << "Error writing " << options.output << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}